@@ -0,0 +1,128 @@
+#ifndef BINARY_MODEL_H
+#define BINARY_MODEL_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <string>
+#include <vector>
+
+#include "gpu_memory.h"
+#include "mesh_file.h"
+
+// A model loaded from a .mesh file. The vertex and index tables go from the file mapping
+// straight into GL buffers, so loading costs one read of the file and two uploads; no
+// text is parsed and nothing is copied on the CPU. Draws with the same attribute layout
+// as the rest of the scene (0 = position, 1 = normal, 2 = texture coordinates) and binds
+// each submesh's material to texture units 0 (diffuse) and 1 (specular).
+class BinaryModel
+{
+public:
+    typedef unsigned int (*TextureLoader)(const char* path);
+
+    // texture paths in the file are resolved against the .mesh file's directory
+    BinaryModel(const std::string& path, TextureLoader loadTexture)
+    {
+        MeshFile file;
+        if (!file.Open(path.c_str()))
+            return;
+        const MeshFileHeader& header = file.Header();
+        boundsMin = glm::vec3(header.boundsMin[0], header.boundsMin[1], header.boundsMin[2]);
+        boundsMax = glm::vec3(header.boundsMax[0], header.boundsMax[1], header.boundsMax[2]);
+
+        glGenVertexArrays(1, &VAO);
+        glGenBuffers(1, &VBO);
+        glGenBuffers(1, &EBO);
+        glBindVertexArray(VAO);
+        glBindBuffer(GL_ARRAY_BUFFER, VBO);
+        glBufferData(GL_ARRAY_BUFFER, header.vertexCount * sizeof(MeshFileVertex), file.Vertices(), GL_STATIC_DRAW);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, header.indexCount * sizeof(std::uint32_t), file.Indices(), GL_STATIC_DRAW);
+        GpuMemory().Allocate(GpuResource::VertexArray, VAO, 0, "3 attributes, indexed", "model");
+        GpuMemory().Allocate(GpuResource::Buffer, VBO, header.vertexCount * sizeof(MeshFileVertex), "GL_ARRAY_BUFFER static", "model");
+        GpuMemory().Allocate(GpuResource::Buffer, EBO, header.indexCount * sizeof(std::uint32_t), "GL_ELEMENT_ARRAY_BUFFER static", "model");
+        glEnableVertexAttribArray(0);
+        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(MeshFileVertex), (void*)offsetof(MeshFileVertex, position));
+        glEnableVertexAttribArray(1);
+        glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(MeshFileVertex), (void*)offsetof(MeshFileVertex, normal));
+        glEnableVertexAttribArray(2);
+        glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(MeshFileVertex), (void*)offsetof(MeshFileVertex, texCoords));
+        glBindVertexArray(0);
+
+        std::string directory = path.substr(0, path.find_last_of("/\\") + 1);
+        for (std::uint32_t i = 0; i < header.materialCount; i++)
+        {
+            const MeshFileMaterial& material = file.Materials()[i];
+            Material loaded;
+            loaded.diffuse = material.diffuse[0] ? loadTexture((directory + material.diffuse).c_str()) : 0;
+            loaded.specular = material.specular[0] ? loadTexture((directory + material.specular).c_str()) : 0;
+            materials.push_back(loaded);
+        }
+        submeshes.assign(file.Submeshes(), file.Submeshes() + header.submeshCount);
+    }
+
+    ~BinaryModel()
+    {
+        for (Material& material : materials)
+        {
+            DeleteTexture(material.diffuse);
+            DeleteTexture(material.specular);
+        }
+        DeleteBuffer(EBO);
+        DeleteBuffer(VBO);
+        DeleteVertexArray(VAO);
+    }
+
+    BinaryModel(const BinaryModel&) = delete;
+    BinaryModel& operator=(const BinaryModel&) = delete;
+
+    bool Loaded() const
+    {
+        return VAO != 0;
+    }
+
+    // bounding sphere around the model's origin, for culling
+    float Radius() const
+    {
+        return glm::max(glm::length(boundsMin), glm::length(boundsMax));
+    }
+
+    void Draw() const
+    {
+        glBindVertexArray(VAO);
+        for (const MeshFileSubmesh& submesh : submeshes)
+        {
+            if (submesh.material < materials.size())
+            {
+                const Material& material = materials[submesh.material];
+                if (material.diffuse)
+                {
+                    glActiveTexture(GL_TEXTURE0);
+                    glBindTexture(GL_TEXTURE_2D, material.diffuse);
+                }
+                if (material.specular)
+                {
+                    glActiveTexture(GL_TEXTURE1);
+                    glBindTexture(GL_TEXTURE_2D, material.specular);
+                    glActiveTexture(GL_TEXTURE0);
+                }
+            }
+            glDrawElements(GL_TRIANGLES, submesh.indexCount, GL_UNSIGNED_INT, (void*)(submesh.firstIndex * sizeof(std::uint32_t)));
+        }
+        glBindVertexArray(0);
+    }
+
+private:
+    struct Material
+    {
+        unsigned int diffuse;
+        unsigned int specular;
+    };
+
+    unsigned int VAO = 0, VBO = 0, EBO = 0;
+    glm::vec3 boundsMin = glm::vec3(0.0f);
+    glm::vec3 boundsMax = glm::vec3(0.0f);
+    std::vector<MeshFileSubmesh> submeshes;
+    std::vector<Material> materials;
+};
+#endif
@@ -0,0 +1,387 @@
+#ifndef BVH_H
+#define BVH_H
+
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <cfloat>
+#include <vector>
+
+#include "frustum.h"
+#include "render_list.h"
+#include "transform_system.h"
+
+struct Aabb
+{
+    glm::vec3 boxMin = glm::vec3(FLT_MAX);
+    glm::vec3 boxMax = glm::vec3(-FLT_MAX);
+
+    void Grow(const Aabb& other)
+    {
+        boxMin = glm::min(boxMin, other.boxMin);
+        boxMax = glm::max(boxMax, other.boxMax);
+    }
+
+    void Grow(const glm::vec3& point)
+    {
+        boxMin = glm::min(boxMin, point);
+        boxMax = glm::max(boxMax, point);
+    }
+
+    glm::vec3 Center() const
+    {
+        return (boxMin + boxMax) * 0.5f;
+    }
+
+    float SurfaceArea() const
+    {
+        glm::vec3 size = glm::max(boxMax - boxMin, glm::vec3(0.0f));
+        return 2.0f * (size.x * size.y + size.y * size.z + size.z * size.x);
+    }
+
+    bool operator!=(const Aabb& other) const
+    {
+        return boxMin != other.boxMin || boxMax != other.boxMax;
+    }
+
+    // entry distance of the ray into the box (0 when it starts inside), or -1 if it misses
+    // within maxDistance; inverseDirection is 1 / direction per axis
+    float RayEntry(const glm::vec3& origin, const glm::vec3& inverseDirection, float maxDistance) const
+    {
+        glm::vec3 t0 = (boxMin - origin) * inverseDirection;
+        glm::vec3 t1 = (boxMax - origin) * inverseDirection;
+        glm::vec3 tNear = glm::min(t0, t1);
+        glm::vec3 tFar = glm::max(t0, t1);
+        float enter = std::max(std::max(tNear.x, tNear.y), std::max(tNear.z, 0.0f));
+        float exit = std::min(std::min(tFar.x, tFar.y), std::min(tFar.z, maxDistance));
+        return enter <= exit ? enter : -1.0f;
+    }
+};
+
+// A bounding volume hierarchy over the scene objects' boxes, built with the surface area
+// heuristic. Moving objects only refit the nodes above them; once refitting has made the
+// tree noticeably worse than a fresh build (by total node surface area) it is rebuilt.
+// Answers ray, sphere and frustum queries in time roughly logarithmic in the object count.
+class Bvh
+{
+public:
+    static const int NO_ITEM = -1;
+
+    void Build(const std::vector<Aabb>& itemBoxes)
+    {
+        boxes = itemBoxes;
+        nodes.clear();
+        items.resize(boxes.size());
+        leafOf.assign(boxes.size(), 0);
+        for (unsigned int i = 0; i < items.size(); i++)
+            items[i] = i;
+        if (items.empty())
+            return;
+        nodes.reserve(2 * items.size());
+        nodes.push_back(Node());
+        Subdivide(0, 0, static_cast<unsigned int>(items.size()), -1, 0);
+        builtCost = Cost();
+        refitCost = builtCost;
+    }
+
+    // moves one item's box; the tree is refitted now and rebuilt by RebuildIfDegraded if needed
+    void Update(unsigned int item, const Aabb& box)
+    {
+        boxes[item] = box;
+        for (int node = leafOf[item]; node >= 0; node = nodes[node].parent)
+        {
+            Node& n = nodes[node];
+            Aabb fitted;
+            if (n.count > 0)
+            {
+                for (unsigned int i = n.first; i < n.first + n.count; i++)
+                    fitted.Grow(boxes[items[i]]);
+            }
+            else
+            {
+                fitted = nodes[n.left].box;
+                fitted.Grow(nodes[n.left + 1].box);
+            }
+            refitCost += fitted.SurfaceArea() - n.box.SurfaceArea();
+            n.box = fitted;
+        }
+    }
+
+    // rebuilds when refits have grown the tree's surface area by more than a third
+    bool RebuildIfDegraded()
+    {
+        if (nodes.empty() || refitCost <= builtCost * 4.0f / 3.0f)
+            return false;
+        std::vector<Aabb> current = boxes;
+        Build(current);
+        return true;
+    }
+
+    unsigned int ItemCount() const
+    {
+        return static_cast<unsigned int>(boxes.size());
+    }
+
+    const Aabb& ItemBox(unsigned int item) const
+    {
+        return boxes[item];
+    }
+
+    // Nearest item along the ray, or NO_ITEM. Boxes are only the first test: hitTest(item,
+    // origin, direction, maxDistance) returns the distance to the item itself, negative for
+    // a miss, and nodes further away than the nearest hit so far are never opened.
+    template <class HitTest>
+    int Raycast(const glm::vec3& origin, const glm::vec3& direction, float maxDistance, HitTest hitTest, float* hitDistance = NULL) const
+    {
+        int nearest = NO_ITEM;
+        if (nodes.empty())
+            return nearest;
+        glm::vec3 inverseDirection(1.0f / direction.x, 1.0f / direction.y, 1.0f / direction.z);
+        int stack[STACK_SIZE];
+        int top = 0;
+        stack[top++] = 0;
+        while (top > 0)
+        {
+            const Node& node = nodes[stack[--top]];
+            if (node.box.RayEntry(origin, inverseDirection, maxDistance) < 0.0f)
+                continue;
+            if (node.count > 0)
+            {
+                for (unsigned int i = node.first; i < node.first + node.count; i++)
+                {
+                    if (boxes[items[i]].RayEntry(origin, inverseDirection, maxDistance) < 0.0f)
+                        continue;
+                    float distance = hitTest(items[i], origin, direction, maxDistance);
+                    if (distance >= 0.0f && distance < maxDistance)
+                    {
+                        maxDistance = distance;
+                        nearest = static_cast<int>(items[i]);
+                    }
+                }
+                continue;
+            }
+            // the nearer child is pushed last so it is opened first
+            float left = nodes[node.left].box.RayEntry(origin, inverseDirection, maxDistance);
+            float right = nodes[node.left + 1].box.RayEntry(origin, inverseDirection, maxDistance);
+            bool leftFirst = left >= 0.0f && (right < 0.0f || left <= right);
+            if (leftFirst)
+            {
+                if (right >= 0.0f)
+                    stack[top++] = node.left + 1;
+                stack[top++] = node.left;
+            }
+            else if (right >= 0.0f)
+            {
+                if (left >= 0.0f)
+                    stack[top++] = node.left;
+                stack[top++] = node.left + 1;
+            }
+        }
+        if (hitDistance && nearest != NO_ITEM)
+            *hitDistance = maxDistance;
+        return nearest;
+    }
+
+    // items whose boxes touch the sphere
+    void QueryRange(const glm::vec3& center, float radius, std::vector<unsigned int>& result) const
+    {
+        Query([&](const Aabb& box) {
+            glm::vec3 closest = glm::clamp(center, box.boxMin, box.boxMax);
+            return glm::dot(closest - center, closest - center) <= radius * radius;
+        }, result);
+    }
+
+    // items whose boxes are at least partly inside the frustum
+    void QueryFrustum(const Frustum& frustum, std::vector<unsigned int>& result) const
+    {
+        Query([&](const Aabb& box) {
+            return frustum.IntersectsBox(box.boxMin, box.boxMax);
+        }, result);
+    }
+
+private:
+    // children are stored next to each other: left and left + 1
+    struct Node
+    {
+        Aabb box;
+        int parent = -1;
+        int left = 0;
+        unsigned int first = 0;
+        unsigned int count = 0;     // items in a leaf, 0 for an inner node
+    };
+
+    static const unsigned int LEAF_SIZE = 4;
+    static const unsigned int BINS = 12;
+    // keeps the traversal stacks (one entry per level plus one) within STACK_SIZE
+    static const int MAX_DEPTH = 48;
+    static const int STACK_SIZE = 64;
+
+    void Subdivide(int index, unsigned int first, unsigned int count, int parent, int depth)
+    {
+        Aabb bounds, centroids;
+        for (unsigned int i = first; i < first + count; i++)
+        {
+            bounds.Grow(boxes[items[i]]);
+            centroids.Grow(boxes[items[i]].Center());
+        }
+        nodes[index].box = bounds;
+        nodes[index].parent = parent;
+
+        unsigned int split = count <= LEAF_SIZE || depth >= MAX_DEPTH ? 0 : FindSplit(first, count, bounds, centroids);
+        if (split == 0)
+        {
+            nodes[index].first = first;
+            nodes[index].count = count;
+            for (unsigned int i = first; i < first + count; i++)
+                leafOf[items[i]] = index;
+            return;
+        }
+        int left = static_cast<int>(nodes.size());
+        nodes[index].left = left;
+        nodes.push_back(Node());
+        nodes.push_back(Node());
+        Subdivide(left, first, split - first, index, depth + 1);
+        Subdivide(left + 1, split, first + count - split, index, depth + 1);
+    }
+
+    // Bins the centroids along each axis and partitions the items at the cheapest bin
+    // boundary. Returns the index of the first item of the right half, or 0 when keeping
+    // the node as one leaf is cheaper (or the centroids are all in one place).
+    unsigned int FindSplit(unsigned int first, unsigned int count, const Aabb& bounds, const Aabb& centroids)
+    {
+        float bestCost = count * bounds.SurfaceArea();
+        int bestAxis = -1;
+        unsigned int bestBin = 0;
+        for (int axis = 0; axis < 3; axis++)
+        {
+            float low = centroids.boxMin[axis], extent = centroids.boxMax[axis] - low;
+            if (extent <= 0.0f)
+                continue;
+            Aabb binBoxes[BINS];
+            unsigned int binCounts[BINS] = {};
+            for (unsigned int i = first; i < first + count; i++)
+            {
+                unsigned int bin = std::min(BINS - 1, static_cast<unsigned int>((boxes[items[i]].Center()[axis] - low) / extent * BINS));
+                binBoxes[bin].Grow(boxes[items[i]]);
+                binCounts[bin]++;
+            }
+            // area and count to the left of each boundary, then sweep from the right
+            float leftArea[BINS - 1];
+            unsigned int leftCount[BINS - 1];
+            Aabb sweep;
+            unsigned int sum = 0;
+            for (unsigned int b = 0; b < BINS - 1; b++)
+            {
+                sweep.Grow(binBoxes[b]);
+                sum += binCounts[b];
+                leftArea[b] = sum > 0 ? sweep.SurfaceArea() : 0.0f;
+                leftCount[b] = sum;
+            }
+            sweep = Aabb();
+            sum = 0;
+            for (unsigned int b = BINS - 1; b > 0; b--)
+            {
+                sweep.Grow(binBoxes[b]);
+                sum += binCounts[b];
+                float cost = leftCount[b - 1] * leftArea[b - 1] + sum * (sum > 0 ? sweep.SurfaceArea() : 0.0f);
+                if (leftCount[b - 1] > 0 && sum > 0 && cost < bestCost)
+                {
+                    bestCost = cost;
+                    bestAxis = axis;
+                    bestBin = b;
+                }
+            }
+        }
+        if (bestAxis < 0)
+            return 0;
+        float low = centroids.boxMin[bestAxis], extent = centroids.boxMax[bestAxis] - low;
+        unsigned int* middle = std::partition(items.data() + first, items.data() + first + count, [&](unsigned int item) {
+            return std::min(BINS - 1, static_cast<unsigned int>((boxes[item].Center()[bestAxis] - low) / extent * BINS)) < bestBin;
+        });
+        return static_cast<unsigned int>(middle - items.data());
+    }
+
+    float Cost() const
+    {
+        float cost = 0.0f;
+        for (const Node& node : nodes)
+            cost += node.box.SurfaceArea();
+        return cost;
+    }
+
+    template <class Overlaps>
+    void Query(Overlaps overlaps, std::vector<unsigned int>& result) const
+    {
+        if (nodes.empty())
+            return;
+        int stack[STACK_SIZE];
+        int top = 0;
+        stack[top++] = 0;
+        while (top > 0)
+        {
+            const Node& node = nodes[stack[--top]];
+            if (!overlaps(node.box))
+                continue;
+            if (node.count > 0)
+            {
+                for (unsigned int i = node.first; i < node.first + node.count; i++)
+                {
+                    if (overlaps(boxes[items[i]]))
+                        result.push_back(items[i]);
+                }
+                continue;
+            }
+            stack[top++] = node.left;
+            stack[top++] = node.left + 1;
+        }
+    }
+
+    std::vector<Node> nodes;
+    std::vector<Aabb> boxes;            // per item
+    std::vector<unsigned int> items;    // item numbers, each leaf owns a range
+    std::vector<int> leafOf;            // per item
+    float builtCost = 0.0f;
+    float refitCost = 0.0f;
+};
+
+// An object's world-space box: the bounding sphere around its model matrix, or a sphere
+// of fallbackRadius for objects without one (the pens).
+inline Aabb ObjectBox(const SceneObject& object, const TransformSystem& transforms, float fallbackRadius)
+{
+    const glm::mat4& model = ObjectModel(object, transforms);
+    float scale = glm::max(glm::length(glm::vec3(model[0])), glm::max(glm::length(glm::vec3(model[1])), glm::length(glm::vec3(model[2]))));
+    float radius = (object.radius > 0.0f ? object.radius : fallbackRadius) * scale;
+    glm::vec3 center = glm::vec3(model[3]) / model[3][3];
+    Aabb box;
+    box.boxMin = center - glm::vec3(radius);
+    box.boxMax = center + glm::vec3(radius);
+    return box;
+}
+
+// Distance along a ray to an object, negative for a miss. Objects drawn from a vertex
+// table are tested against the unit cube all those tables fit in, under the model
+// matrix, and are hit from inside as well, so the walls can be picked; objects that draw
+// themselves count as hit wherever the ray enters their bounding box.
+inline float RayHitsObject(const SceneObject& object, const TransformSystem& transforms, const Aabb& box,
+                           const glm::vec3& origin, const glm::vec3& direction, float maxDistance)
+{
+    if (object.draw)
+    {
+        glm::vec3 inverseDirection(1.0f / direction.x, 1.0f / direction.y, 1.0f / direction.z);
+        return box.RayEntry(origin, inverseDirection, maxDistance);
+    }
+    glm::mat4 toLocal = glm::inverse(ObjectModel(object, transforms));
+    glm::vec3 localOrigin = glm::vec3(toLocal * glm::vec4(origin, 1.0f));
+    glm::vec3 localDirection = glm::vec3(toLocal * glm::vec4(direction, 0.0f));
+    // distances along localDirection equal distances along direction, as it was not normalized
+    glm::vec3 t0 = (glm::vec3(-0.5f) - localOrigin) / localDirection;
+    glm::vec3 t1 = (glm::vec3(0.5f) - localOrigin) / localDirection;
+    glm::vec3 tNear = glm::min(t0, t1);
+    glm::vec3 tFar = glm::max(t0, t1);
+    float enter = std::max(std::max(tNear.x, tNear.y), tNear.z);
+    float exit = std::min(std::min(tFar.x, tFar.y), std::min(tFar.z, maxDistance));
+    if (enter > exit || exit < 0.0f)
+        return -1.0f;
+    return enter >= 0.0f ? enter : exit;
+}
+#endif
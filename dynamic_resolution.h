@@ -0,0 +1,154 @@
+#ifndef DYNAMIC_RESOLUTION_H
+#define DYNAMIC_RESOLUTION_H
+
+#include <glad/glad.h>
+
+#include "gpu_memory.h"
+
+#include <cmath>
+#include <iostream>
+
+// Renders the scene into an offscreen color/depth target sized to a fraction of the
+// window, then stretches it over the window with a linear blit. The fraction follows
+// the GPU time of the scene, read back from GL_TIME_ELAPSED queries a few frames late
+// so the CPU never waits on them: over budget it drops quickly, comfortably under
+// budget it creeps back towards full resolution.
+class DynamicResolution
+{
+public:
+    static const unsigned int QUERIES = 4;
+
+    DynamicResolution(float budgetMs, float minScale = 0.5f)
+        : budgetMs(budgetMs), minScale(minScale)
+    {
+        glGenFramebuffers(1, &fbo);
+        glGenRenderbuffers(1, &colorBuffer);
+        glGenRenderbuffers(1, &depthBuffer);
+        glGenQueries(QUERIES, queries);
+    }
+
+    ~DynamicResolution()
+    {
+        glDeleteQueries(QUERIES, queries);
+        DeleteRenderbuffer(depthBuffer);
+        DeleteRenderbuffer(colorBuffer);
+        glDeleteFramebuffers(1, &fbo);
+    }
+
+    DynamicResolution(const DynamicResolution&) = delete;
+    DynamicResolution& operator=(const DynamicResolution&) = delete;
+
+    float Scale() const
+    {
+        return scale;
+    }
+
+    float GpuMilliseconds() const
+    {
+        return gpuMs;
+    }
+
+    // binds the offscreen target at the current scale; windowWidth/Height is the framebuffer size
+    void BeginFrame(int windowWidth, int windowHeight)
+    {
+        if (windowWidth != width || windowHeight != height)
+            Resize(windowWidth, windowHeight);
+        ReadFinishedQueries();
+
+        // multiples of 8 keep the size from changing on every small adjustment
+        renderWidth = static_cast<int>(std::ceil(width * scale / 8.0f)) * 8;
+        renderHeight = static_cast<int>(std::ceil(height * scale / 8.0f)) * 8;
+        renderWidth = renderWidth < width ? renderWidth : width;
+        renderHeight = renderHeight < height ? renderHeight : height;
+
+        glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+        glViewport(0, 0, renderWidth, renderHeight);
+        glBeginQuery(GL_TIME_ELAPSED, queries[current]);
+    }
+
+    // stops timing and upscales the rendered region to the default framebuffer
+    void EndFrame()
+    {
+        glEndQuery(GL_TIME_ELAPSED);
+        issued[current] = true;
+        current = (current + 1) % QUERIES;
+
+        glBindFramebuffer(GL_READ_FRAMEBUFFER, fbo);
+        glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
+        glBlitFramebuffer(0, 0, renderWidth, renderHeight, 0, 0, width, height, GL_COLOR_BUFFER_BIT, GL_LINEAR);
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        glViewport(0, 0, width, height);
+    }
+
+private:
+    float budgetMs;
+    float minScale;
+    float scale = 1.0f;
+    float gpuMs = 0.0f;
+    int width = 0;
+    int height = 0;
+    int renderWidth = 0;
+    int renderHeight = 0;
+    unsigned int fbo = 0;
+    unsigned int colorBuffer = 0;
+    unsigned int depthBuffer = 0;
+    unsigned int queries[QUERIES] = {};
+    bool issued[QUERIES] = {};
+    unsigned int current = 0;
+
+    // storage is allocated at full window size; lower scales use its lower-left corner
+    void Resize(int windowWidth, int windowHeight)
+    {
+        width = windowWidth > 1 ? windowWidth : 1;
+        height = windowHeight > 1 ? windowHeight : 1;
+        glBindRenderbuffer(GL_RENDERBUFFER, colorBuffer);
+        glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, width, height);
+        glBindRenderbuffer(GL_RENDERBUFFER, depthBuffer);
+        glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, width, height);
+        glBindRenderbuffer(GL_RENDERBUFFER, 0);
+        const std::string size = std::to_string(width) + "x" + std::to_string(height);
+        GpuMemory().Allocate(GpuResource::Renderbuffer, colorBuffer, static_cast<std::size_t>(width) * height * 4, "RGBA8 " + size, "dynamic resolution");
+        GpuMemory().Allocate(GpuResource::Renderbuffer, depthBuffer, static_cast<std::size_t>(width) * height * 4, "DEPTH24_STENCIL8 " + size, "dynamic resolution");
+
+        glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+        glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, colorBuffer);
+        glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, depthBuffer);
+        if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+            std::cout << "ERROR::FRAMEBUFFER:: Dynamic resolution target is not complete!" << std::endl;
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    }
+
+    void ReadFinishedQueries()
+    {
+        // the oldest query first; stop at the first one the GPU has not reached yet
+        for (unsigned int i = 0; i < QUERIES; i++)
+        {
+            unsigned int query = (current + i) % QUERIES;
+            if (!issued[query])
+                continue;
+            GLint available = 0;
+            glGetQueryObjectiv(queries[query], GL_QUERY_RESULT_AVAILABLE, &available);
+            if (!available)
+                break;
+            GLuint64 nanoseconds = 0;
+            glGetQueryObjectui64v(queries[query], GL_QUERY_RESULT, &nanoseconds);
+            issued[query] = false;
+            Adjust(static_cast<float>(nanoseconds / 1.0e6));
+        }
+    }
+
+    void Adjust(float frameMs)
+    {
+        gpuMs = frameMs;
+        if (frameMs <= 0.0f)
+            return;
+        // GPU time follows the pixel count, which goes with the square of the scale
+        float target = scale * std::sqrt(budgetMs / frameMs);
+        target = target < minScale ? minScale : (target > 1.0f ? 1.0f : target);
+        if (frameMs > budgetMs)
+            scale += (target - scale) * 0.5f;
+        else if (frameMs < budgetMs * 0.85f)
+            scale += (target - scale) * 0.1f;
+    }
+};
+#endif
@@ -0,0 +1,169 @@
+#ifndef FRAME_ARENA_H
+#define FRAME_ARENA_H
+
+#include <atomic>
+#include <cstddef>
+#include <mutex>
+#include <new>
+#include <type_traits>
+#include <vector>
+
+// Every operator new in the program, counted by the replacement operators in source.cpp.
+// The render loop checks it stays put across a frame.
+inline std::atomic<unsigned long long>& HeapAllocations()
+{
+    static std::atomic<unsigned long long> count(0);
+    return count;
+}
+
+// A bump allocator for data that lives for one frame. It has two halves and alternates
+// between them, so what a frame allocated stays valid through the next frame, long
+// enough for anything handed to the GPU. Nothing is freed one by one; BeginFrame()
+// discards the half of the frame before last in one go.
+//
+// Allocate() is thread-safe (a single atomic add), so worker threads can build their
+// lists in it. When a frame needs more than a half holds, the rest comes from the heap
+// and the half grows to fit the next time it is reset; after the first few frames the
+// arena no longer touches the heap at all.
+class FrameArena
+{
+public:
+    explicit FrameArena(std::size_t bytesPerFrame)
+    {
+        for (Half& half : halves)
+        {
+            half.block = new char[bytesPerFrame];
+            half.capacity = bytesPerFrame;
+        }
+    }
+
+    ~FrameArena()
+    {
+        for (Half& half : halves)
+        {
+            FreeOverflow(half);
+            delete[] half.block;
+        }
+    }
+
+    FrameArena(const FrameArena&) = delete;
+    FrameArena& operator=(const FrameArena&) = delete;
+
+    // GL thread, between frames: no other thread may be allocating
+    void BeginFrame()
+    {
+        current ^= 1;
+        Half& half = halves[current];
+        const std::size_t needed = half.used.load();
+        if (needed > half.capacity)
+        {
+            delete[] half.block;
+            half.capacity = needed + needed / 2;
+            half.block = new char[half.capacity];
+        }
+        FreeOverflow(half);
+        half.used = 0;
+    }
+
+    void* Allocate(std::size_t bytes, std::size_t alignment)
+    {
+        Half& half = halves[current];
+        std::size_t offset = half.used.fetch_add(bytes + alignment - 1);
+        if (offset + bytes + alignment - 1 <= half.capacity)
+        {
+            std::size_t address = reinterpret_cast<std::size_t>(half.block + offset);
+            return reinterpret_cast<void*>((address + alignment - 1) / alignment * alignment);
+        }
+        void* memory = ::operator new(bytes);
+        std::lock_guard<std::mutex> lock(half.overflowMutex);
+        half.overflow.push_back(memory);
+        return memory;
+    }
+
+    // bytes handed out this frame, including any that went to the heap
+    std::size_t UsedBytes() const
+    {
+        return halves[current].used.load();
+    }
+
+    std::size_t CapacityBytes() const
+    {
+        return halves[current].capacity;
+    }
+
+private:
+    struct Half
+    {
+        char* block = NULL;
+        std::size_t capacity = 0;
+        std::atomic<std::size_t> used{ 0 };
+        std::mutex overflowMutex;
+        std::vector<void*> overflow;
+    };
+
+    Half halves[2];
+    int current = 0;
+
+    static void FreeOverflow(Half& half)
+    {
+        for (void* memory : half.overflow)
+            ::operator delete(memory);
+        half.overflow.clear();
+    }
+};
+
+// Lets standard containers allocate from a FrameArena. Deallocation does nothing; the
+// memory goes when the arena moves past the frame. Without an arena it is a plain heap
+// allocator, for code that also runs outside the render loop.
+template <class T>
+class FrameAllocator
+{
+public:
+    typedef T value_type;
+    typedef std::true_type propagate_on_container_copy_assignment;
+    typedef std::true_type propagate_on_container_move_assignment;
+    typedef std::true_type propagate_on_container_swap;
+
+    explicit FrameAllocator(FrameArena* arena = NULL)
+        : arena(arena)
+    {
+    }
+
+    template <class U>
+    FrameAllocator(const FrameAllocator<U>& other)
+        : arena(other.arena)
+    {
+    }
+
+    T* allocate(std::size_t count)
+    {
+        if (arena)
+            return static_cast<T*>(arena->Allocate(count * sizeof(T), alignof(T)));
+        return static_cast<T*>(::operator new(count * sizeof(T)));
+    }
+
+    void deallocate(T* memory, std::size_t)
+    {
+        if (!arena)
+            ::operator delete(memory);
+    }
+
+    FrameArena* arena;
+};
+
+template <class T, class U>
+bool operator==(const FrameAllocator<T>& a, const FrameAllocator<U>& b)
+{
+    return a.arena == b.arena;
+}
+
+template <class T, class U>
+bool operator!=(const FrameAllocator<T>& a, const FrameAllocator<U>& b)
+{
+    return a.arena != b.arena;
+}
+
+// a vector that is rebuilt every frame; assign it a fresh one at the start of each frame
+template <class T>
+using FrameVector = std::vector<T, FrameAllocator<T>>;
+#endif
@@ -0,0 +1,99 @@
+#ifndef FRAME_PACER_H
+#define FRAME_PACER_H
+
+#include <chrono>
+#include <thread>
+
+// Holds the loop to a target frame rate without sampling input early. Instead of
+// sleeping after a frame is presented, WaitForNextFrame() sleeps until just before the
+// next frame has to start, leaving only the time the recent frames took to render, so
+// input read right after it is as fresh as possible when the frame reaches the screen.
+//
+// It also measures, per frame, the time from sampling input to glfwSwapBuffers returning
+// (input-to-present latency) and the time between presents, averaged over each second.
+class FramePacer
+{
+public:
+    // targetFps == 0 paces nothing and only measures
+    explicit FramePacer(double targetFps = 0.0)
+    {
+        SetTarget(targetFps);
+        lastPresent = Clock::now();
+        reportStart = lastPresent;
+        nextPresent = lastPresent;
+    }
+
+    void SetTarget(double targetFps)
+    {
+        period = targetFps > 0.0 ? Seconds(1.0 / targetFps) : Seconds(0.0);
+    }
+
+    // sleeps until the latest moment the next frame can start and still present on time
+    void WaitForNextFrame()
+    {
+        if (period.count() <= 0.0)
+            return;
+        Clock::time_point now = Clock::now();
+        nextPresent += std::chrono::duration_cast<Clock::duration>(period);
+        if (nextPresent < now)
+            nextPresent = now;  // fell behind (or the loop was idle); don't try to catch up
+        const std::chrono::microseconds safetyMargin(500);
+        const std::chrono::milliseconds sleepSlack(2);
+        Clock::time_point start = nextPresent - std::chrono::duration_cast<Clock::duration>(workEstimate + safetyMargin);
+        // the OS may oversleep by a millisecond or more, so sleep short and spin the rest
+        if (start - now > sleepSlack)
+            std::this_thread::sleep_for(start - now - sleepSlack);
+        while (Clock::now() < start)
+            std::this_thread::yield();
+    }
+
+    // call right after polling events, before the input is used
+    void InputSampled()
+    {
+        inputTime = Clock::now();
+    }
+
+    // call right after glfwSwapBuffers
+    void Presented()
+    {
+        Clock::time_point now = Clock::now();
+        Seconds latency = now - inputTime;
+        Seconds frameTime = now - lastPresent;
+        lastPresent = now;
+        // smoothed, and biased toward slow frames so a spike is not missed next frame
+        workEstimate = latency > workEstimate ? latency : workEstimate * 0.9 + latency * 0.1;
+
+        latencySum += latency.count();
+        frameTimeSum += frameTime.count();
+        frames++;
+    }
+
+    // true about once a second, with the averages (in milliseconds) since the last report
+    bool Report(double& averageFrameMs, double& averageLatencyMs)
+    {
+        if (frames == 0 || Clock::now() - reportStart < std::chrono::seconds(1))
+            return false;
+        averageFrameMs = frameTimeSum / frames * 1000.0;
+        averageLatencyMs = latencySum / frames * 1000.0;
+        frameTimeSum = 0.0;
+        latencySum = 0.0;
+        frames = 0;
+        reportStart = Clock::now();
+        return true;
+    }
+
+private:
+    typedef std::chrono::steady_clock Clock;
+    typedef std::chrono::duration<double> Seconds;
+
+    Seconds period{ 0.0 };
+    Seconds workEstimate{ 0.0 };
+    Clock::time_point nextPresent;
+    Clock::time_point lastPresent;
+    Clock::time_point inputTime;
+    Clock::time_point reportStart;
+    double latencySum = 0.0;
+    double frameTimeSum = 0.0;
+    unsigned int frames = 0;
+};
+#endif
@@ -0,0 +1,277 @@
+#ifndef FRAME_PROFILER_H
+#define FRAME_PROFILER_H
+
+#include <glad/glad.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <vector>
+
+// one finished scope; names are string literals and are never copied
+struct ProfileEvent
+{
+    const char* name;
+    long long startNs;
+    long long endNs;
+    unsigned int frame;
+};
+
+// The last CAPACITY events of one thread. Only the owning thread writes, so recording is
+// a store and a release of the write count; a reader copies what is there and drops the
+// slots the writer may have overwritten while it was copying.
+class ProfileRing
+{
+public:
+    static const unsigned int CAPACITY = 1 << 14;
+
+    explicit ProfileRing(const std::string& name)
+        : name(name)
+    {
+    }
+
+    const std::string& Name() const
+    {
+        return name;
+    }
+
+    void Push(const ProfileEvent& event)
+    {
+        unsigned long long count = written.load(std::memory_order_relaxed);
+        events[count & (CAPACITY - 1)] = event;
+        written.store(count + 1, std::memory_order_release);
+    }
+
+    void Snapshot(std::vector<ProfileEvent>& out) const
+    {
+        unsigned long long end = written.load(std::memory_order_acquire);
+        unsigned long long begin = end > CAPACITY ? end - CAPACITY : 0;
+        std::size_t first = out.size();
+        for (unsigned long long i = begin; i < end; i++)
+            out.push_back(events[i & (CAPACITY - 1)]);
+        unsigned long long after = written.load(std::memory_order_acquire);
+        if (after > CAPACITY && after - CAPACITY > begin)
+        {
+            std::size_t overwritten = static_cast<std::size_t>(std::min(after - CAPACITY - begin, end - begin));
+            out.erase(out.begin() + first, out.begin() + first + overwritten);
+        }
+    }
+
+private:
+    std::string name;
+    ProfileEvent events[CAPACITY];
+    std::atomic<unsigned long long> written{ 0 };
+};
+
+// Collects scopes from every thread into per-thread rings and writes the last frames of
+// them as Chrome trace JSON (chrome://tracing, ui.perfetto.dev). Rings are registered
+// once per thread without a lock and live as long as the process.
+class FrameProfiler
+{
+public:
+    static const unsigned int MAX_RINGS = 64;
+
+    long long NowNs() const
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - epoch).count();
+    }
+
+    unsigned int Frame() const
+    {
+        return frame.load(std::memory_order_relaxed);
+    }
+
+    // the GL thread starts each frame with this; scopes are tagged with the frame they start in
+    void BeginFrame()
+    {
+        frame.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    // the calling thread's ring, created on first use; a thread can name itself by
+    // calling this before its first scope
+    ProfileRing& ThreadRing(const char* name = NULL)
+    {
+        static thread_local ProfileRing* ring = NULL;
+        if (!ring)
+            ring = Register(name ? std::string(name) : "thread " + std::to_string(ringCount.load()));
+        return *ring;
+    }
+
+    // a ring that is not tied to a thread, such as the GPU timeline
+    ProfileRing* Register(const std::string& name)
+    {
+        unsigned int index = ringCount.fetch_add(1);
+        if (index >= MAX_RINGS)
+            return &overflow;
+        ProfileRing* ring = new ProfileRing(name);
+        rings[index].store(ring, std::memory_order_release);
+        return ring;
+    }
+
+    // writes the events of the last frameCount frames; false if the file cannot be written
+    bool WriteChromeTrace(const std::string& path, unsigned int frameCount) const
+    {
+        std::ofstream file(path.c_str(), std::ios::trunc);
+        if (!file)
+            return false;
+        unsigned int current = Frame();
+        unsigned int firstFrame = current > frameCount ? current - frameCount : 0;
+        file << "{\"traceEvents\":[\n";
+        bool first = true;
+        unsigned int count = ringCount.load();
+        count = count < MAX_RINGS ? count : MAX_RINGS;
+        std::vector<ProfileEvent> events;
+        for (unsigned int tid = 0; tid < count; tid++)
+        {
+            const ProfileRing* ring = rings[tid].load(std::memory_order_acquire);
+            if (!ring)
+                continue;
+            file << (first ? "" : ",\n") << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << tid << ",\"args\":{\"name\":\"" << ring->Name() << "\"}}";
+            first = false;
+            events.clear();
+            ring->Snapshot(events);
+            for (const ProfileEvent& event : events)
+            {
+                if (event.frame < firstFrame)
+                    continue;
+                char line[256];
+                std::snprintf(line, sizeof(line), ",\n{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f,\"args\":{\"frame\":%u}}",
+                              event.name, tid, event.startNs / 1000.0, (event.endNs - event.startNs) / 1000.0, event.frame);
+                file << line;
+            }
+        }
+        file << "\n]}\n";
+        return file.good();
+    }
+
+private:
+    typedef std::chrono::steady_clock Clock;
+
+    Clock::time_point epoch = Clock::now();
+    std::atomic<unsigned int> frame{ 0 };
+    std::atomic<ProfileRing*> rings[MAX_RINGS] = {};
+    std::atomic<unsigned int> ringCount{ 0 };
+    ProfileRing overflow{ "overflow" };     // threads past MAX_RINGS share it and are not written out
+};
+
+inline FrameProfiler& Profiler()
+{
+    static FrameProfiler profiler;
+    return profiler;
+}
+
+// GPU ranges from GL_TIMESTAMP queries. Each frame's queries are read back FRAMES frames
+// later, when the GPU has long finished them, and go into their own ring on the CPU time
+// line: GPU timestamps are mapped to the profiler clock by a periodic calibration.
+class GpuTimeline
+{
+public:
+    static const unsigned int FRAMES = 4;
+    static const unsigned int RANGES = 32;
+
+    GpuTimeline()
+        : ring(Profiler().Register("GPU"))
+    {
+        glGenQueries(FRAMES * RANGES * 2, &queries[0][0]);
+        Calibrate();
+    }
+
+    ~GpuTimeline()
+    {
+        glDeleteQueries(FRAMES * RANGES * 2, &queries[0][0]);
+    }
+
+    GpuTimeline(const GpuTimeline&) = delete;
+    GpuTimeline& operator=(const GpuTimeline&) = delete;
+
+    // reads back the frame that used this slot last, then starts recording into it
+    void BeginFrame()
+    {
+        current = (current + 1) % FRAMES;
+        Resolve(current);
+        frames[current] = Profiler().Frame();
+        if (++framesSinceCalibration >= 256)
+            Calibrate();
+    }
+
+    // returns a range index for End(), or -1 once the frame has used up its queries
+    int Begin(const char* name)
+    {
+        if (counts[current] >= RANGES)
+            return -1;
+        int range = static_cast<int>(counts[current]++);
+        names[current][range] = name;
+        glQueryCounter(queries[current][range * 2], GL_TIMESTAMP);
+        return range;
+    }
+
+    void End(int range)
+    {
+        if (range >= 0)
+            glQueryCounter(queries[current][range * 2 + 1], GL_TIMESTAMP);
+    }
+
+private:
+    ProfileRing* ring;
+    unsigned int queries[FRAMES][RANGES * 2];
+    const char* names[FRAMES][RANGES] = {};
+    unsigned int counts[FRAMES] = {};
+    unsigned int frames[FRAMES] = {};
+    unsigned int current = 0;
+    unsigned int framesSinceCalibration = 0;
+    long long gpuToCpuNs = 0;
+
+    void Resolve(unsigned int slot)
+    {
+        for (unsigned int range = 0; range < counts[slot]; range++)
+        {
+            GLuint64 start = 0, end = 0;
+            glGetQueryObjectui64v(queries[slot][range * 2], GL_QUERY_RESULT, &start);
+            glGetQueryObjectui64v(queries[slot][range * 2 + 1], GL_QUERY_RESULT, &end);
+            ring->Push(ProfileEvent{ names[slot][range], static_cast<long long>(start) + gpuToCpuNs, static_cast<long long>(end) + gpuToCpuNs, frames[slot] });
+        }
+        counts[slot] = 0;
+    }
+
+    // the GPU clock read now against the CPU clock read now; good to well under a
+    // millisecond, which is finer than the ranges it places
+    void Calibrate()
+    {
+        GLint64 gpuNow = 0;
+        glGetInteger64v(GL_TIMESTAMP, &gpuNow);
+        gpuToCpuNs = Profiler().NowNs() - static_cast<long long>(gpuNow);
+        framesSinceCalibration = 0;
+    }
+};
+
+// Times the enclosing scope on the calling thread and, given a timeline, on the GPU too.
+//   ProfileScope scope("light cubes", gpuTimeline);
+class ProfileScope
+{
+public:
+    explicit ProfileScope(const char* name, GpuTimeline* gpu = NULL)
+        : name(name), gpu(gpu), gpuRange(gpu ? gpu->Begin(name) : -1), startNs(Profiler().NowNs()), frame(Profiler().Frame())
+    {
+    }
+
+    ~ProfileScope()
+    {
+        Profiler().ThreadRing().Push(ProfileEvent{ name, startNs, Profiler().NowNs(), frame });
+        if (gpu)
+            gpu->End(gpuRange);
+    }
+
+    ProfileScope(const ProfileScope&) = delete;
+    ProfileScope& operator=(const ProfileScope&) = delete;
+
+private:
+    const char* name;
+    GpuTimeline* gpu;
+    int gpuRange;
+    long long startNs;
+    unsigned int frame;
+};
+#endif
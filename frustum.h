@@ -0,0 +1,56 @@
+#ifndef FRUSTUM_H
+#define FRUSTUM_H
+
+#include <glm/glm.hpp>
+
+// The six clip planes of a view-projection matrix, pointing inwards, used to reject
+// objects that cannot be on screen.
+struct Frustum
+{
+    glm::vec4 planes[6];
+
+    static Frustum FromMatrix(const glm::mat4& viewProjection)
+    {
+        // Gribb/Hartmann: each plane is the fourth row of the matrix plus or minus another row
+        glm::vec4 row0(viewProjection[0][0], viewProjection[1][0], viewProjection[2][0], viewProjection[3][0]);
+        glm::vec4 row1(viewProjection[0][1], viewProjection[1][1], viewProjection[2][1], viewProjection[3][1]);
+        glm::vec4 row2(viewProjection[0][2], viewProjection[1][2], viewProjection[2][2], viewProjection[3][2]);
+        glm::vec4 row3(viewProjection[0][3], viewProjection[1][3], viewProjection[2][3], viewProjection[3][3]);
+
+        Frustum frustum;
+        frustum.planes[0] = row3 + row0;  // left
+        frustum.planes[1] = row3 - row0;  // right
+        frustum.planes[2] = row3 + row1;  // bottom
+        frustum.planes[3] = row3 - row1;  // top
+        frustum.planes[4] = row3 + row2;  // near
+        frustum.planes[5] = row3 - row2;  // far
+        for (int i = 0; i < 6; i++)
+            frustum.planes[i] /= glm::length(glm::vec3(frustum.planes[i]));
+        return frustum;
+    }
+
+    bool IntersectsSphere(const glm::vec3& center, float radius) const
+    {
+        for (int i = 0; i < 6; i++)
+        {
+            if (glm::dot(glm::vec3(planes[i]), center) + planes[i].w < -radius)
+                return false;
+        }
+        return true;
+    }
+
+    bool IntersectsBox(const glm::vec3& boxMin, const glm::vec3& boxMax) const
+    {
+        for (int i = 0; i < 6; i++)
+        {
+            // the box corner furthest along the plane normal
+            glm::vec3 corner(planes[i].x >= 0.0f ? boxMax.x : boxMin.x,
+                             planes[i].y >= 0.0f ? boxMax.y : boxMin.y,
+                             planes[i].z >= 0.0f ? boxMax.z : boxMin.z);
+            if (glm::dot(glm::vec3(planes[i]), corner) + planes[i].w < 0.0f)
+                return false;
+        }
+        return true;
+    }
+};
+#endif
@@ -0,0 +1,393 @@
+#ifndef GL_COUNTERS_H
+#define GL_COUNTERS_H
+
+#include <glad/glad.h>
+
+// Counts the GL calls the scene makes each frame. Build with GL_COUNTERS defined (before
+// this header, or /DGL_COUNTERS in the project) and every draw, bind, uniform setter,
+// buffer or texture upload, object creation and program switch made in the code included
+// after this header goes through a counting wrapper. GL_COUNTERS_END_FRAME() then writes
+// the frame's totals as one line of gl_counters.csv and prints one frame a second.
+//
+// Without GL_COUNTERS the header defines nothing but empty macros, and the GL names are
+// glad's own.
+#ifdef GL_COUNTERS
+
+#include <atomic>
+#include <cstdio>
+#include <fstream>
+#include <map>
+
+struct GlFrameCounters
+{
+    unsigned int draws = 0;
+    unsigned long long vertices = 0;
+    unsigned int binds = 0;
+    unsigned int redundantBinds = 0;    // bound what was bound already
+    unsigned int uniformSets = 0;
+    unsigned int uploads = 0;
+    unsigned long long uploadBytes = 0; // glBufferData, glBufferSubData, glTexImage2D
+    unsigned int programSwitches = 0;
+    unsigned int redundantPrograms = 0;
+    unsigned int stateChanges = 0;      // binds and programs that changed something, enables, masks, viewports
+    unsigned int objectsCreated = 0;    // glGen* and glCreateProgram; nonzero in a steady frame is a leak or churn
+};
+
+class GlCounterLog
+{
+public:
+    GlFrameCounters frame;
+    std::atomic<unsigned long long> mappedBytes{ 0 };  // written into mapped buffers, from any thread
+
+    // state as the wrappers last set it, to tell changes from redundant calls
+    GLuint program = 0;
+    GLuint vertexArray = 0;
+    GLuint framebuffer = 0;
+    GLenum activeTexture = GL_TEXTURE0;
+    std::map<GLenum, GLuint> textures;  // per unit
+    std::map<GLenum, GLuint> buffers;   // per target; missing until known
+
+    void Bind(bool changed)
+    {
+        frame.binds++;
+        if (changed)
+            frame.stateChanges++;
+        else
+            frame.redundantBinds++;
+    }
+
+    void EndFrame()
+    {
+        if (!csv.is_open())
+        {
+            csv.open("gl_counters.csv", std::ios::trunc);
+            csv << "frame,draws,vertices,binds,redundant_binds,uniform_sets,uploads,upload_bytes,mapped_bytes,program_switches,redundant_programs,state_changes,objects_created\n";
+        }
+        unsigned long long mapped = mappedBytes.exchange(0);
+        csv << frameNumber << "," << frame.draws << "," << frame.vertices << "," << frame.binds << "," << frame.redundantBinds << "," << frame.uniformSets << ","
+            << frame.uploads << "," << frame.uploadBytes << "," << mapped << "," << frame.programSwitches << "," << frame.redundantPrograms << ","
+            << frame.stateChanges << "," << frame.objectsCreated << "\n";
+        if (frameNumber % 60 == 0)
+            std::printf("GL frame %u: %u draws, %u binds (%u redundant), %u uniforms, %u uploads (%llu + %llu mapped bytes), %u programs (%u redundant), %u state changes, %u created\n",
+                        frameNumber, frame.draws, frame.binds, frame.redundantBinds, frame.uniformSets, frame.uploads, frame.uploadBytes, mapped,
+                        frame.programSwitches, frame.redundantPrograms, frame.stateChanges, frame.objectsCreated);
+        frame = GlFrameCounters();
+        frameNumber++;
+    }
+
+private:
+    std::ofstream csv;
+    unsigned int frameNumber = 0;
+};
+
+inline GlCounterLog& GlCounters()
+{
+    static GlCounterLog log;
+    return log;
+}
+
+inline GLsizeiptr GlPixelBytes(GLenum format, GLenum type, GLsizei width, GLsizei height)
+{
+    int components = format == GL_RED ? 1 : (format == GL_RGB ? 3 : 4);
+    int componentBytes = type == GL_UNSIGNED_BYTE ? 1 : 4;
+    return static_cast<GLsizeiptr>(width) * height * components * componentBytes;
+}
+
+// draws
+inline void CountedDrawArrays(GLenum mode, GLint first, GLsizei count)
+{
+    GlCounters().frame.draws++;
+    GlCounters().frame.vertices += count;
+    glad_glDrawArrays(mode, first, count);
+}
+
+inline void CountedDrawElements(GLenum mode, GLsizei count, GLenum type, const void* indices)
+{
+    GlCounters().frame.draws++;
+    GlCounters().frame.vertices += count;
+    glad_glDrawElements(mode, count, type, indices);
+}
+
+// binds
+inline void CountedBindVertexArray(GLuint array)
+{
+    GlCounterLog& log = GlCounters();
+    log.Bind(log.vertexArray != array);
+    if (log.vertexArray != array)
+        log.buffers.erase(GL_ELEMENT_ARRAY_BUFFER);   // the index buffer belongs to the vertex array
+    log.vertexArray = array;
+    glad_glBindVertexArray(array);
+}
+
+inline void CountedBindBuffer(GLenum target, GLuint buffer)
+{
+    GlCounterLog& log = GlCounters();
+    std::map<GLenum, GLuint>::const_iterator bound = log.buffers.find(target);
+    log.Bind(bound == log.buffers.end() || bound->second != buffer);
+    log.buffers[target] = buffer;
+    glad_glBindBuffer(target, buffer);
+}
+
+// indexed ranges are always counted as changes; the offset moves with every draw
+inline void CountedBindBufferRange(GLenum target, GLuint index, GLuint buffer, GLintptr offset, GLsizeiptr size)
+{
+    GlCounters().Bind(true);
+    glad_glBindBufferRange(target, index, buffer, offset, size);
+}
+
+inline void CountedBindBufferBase(GLenum target, GLuint index, GLuint buffer)
+{
+    GlCounters().Bind(true);
+    glad_glBindBufferBase(target, index, buffer);
+}
+
+inline void CountedActiveTexture(GLenum texture)
+{
+    GlCounterLog& log = GlCounters();
+    log.Bind(log.activeTexture != texture);
+    log.activeTexture = texture;
+    glad_glActiveTexture(texture);
+}
+
+inline void CountedBindTexture(GLenum target, GLuint texture)
+{
+    GlCounterLog& log = GlCounters();
+    log.Bind(log.textures[log.activeTexture] != texture);
+    log.textures[log.activeTexture] = texture;
+    glad_glBindTexture(target, texture);
+}
+
+inline void CountedBindFramebuffer(GLenum target, GLuint framebuffer)
+{
+    GlCounterLog& log = GlCounters();
+    log.Bind(target != GL_FRAMEBUFFER || log.framebuffer != framebuffer);
+    if (target == GL_FRAMEBUFFER)
+        log.framebuffer = framebuffer;
+    glad_glBindFramebuffer(target, framebuffer);
+}
+
+// program switches
+inline void CountedUseProgram(GLuint program)
+{
+    GlCounterLog& log = GlCounters();
+    if (log.program == program)
+    {
+        log.frame.redundantPrograms++;
+    }
+    else
+    {
+        log.frame.programSwitches++;
+        log.frame.stateChanges++;
+    }
+    log.program = program;
+    glad_glUseProgram(program);
+}
+
+// uniform setters
+inline void CountedUniform1i(GLint location, GLint v0)
+{
+    GlCounters().frame.uniformSets++;
+    glad_glUniform1i(location, v0);
+}
+
+inline void CountedUniform1f(GLint location, GLfloat v0)
+{
+    GlCounters().frame.uniformSets++;
+    glad_glUniform1f(location, v0);
+}
+
+inline void CountedUniform2fv(GLint location, GLsizei count, const GLfloat* value)
+{
+    GlCounters().frame.uniformSets++;
+    glad_glUniform2fv(location, count, value);
+}
+
+inline void CountedUniform3f(GLint location, GLfloat v0, GLfloat v1, GLfloat v2)
+{
+    GlCounters().frame.uniformSets++;
+    glad_glUniform3f(location, v0, v1, v2);
+}
+
+inline void CountedUniform3fv(GLint location, GLsizei count, const GLfloat* value)
+{
+    GlCounters().frame.uniformSets++;
+    glad_glUniform3fv(location, count, value);
+}
+
+inline void CountedUniform4fv(GLint location, GLsizei count, const GLfloat* value)
+{
+    GlCounters().frame.uniformSets++;
+    glad_glUniform4fv(location, count, value);
+}
+
+inline void CountedUniformMatrix3fv(GLint location, GLsizei count, GLboolean transpose, const GLfloat* value)
+{
+    GlCounters().frame.uniformSets++;
+    glad_glUniformMatrix3fv(location, count, transpose, value);
+}
+
+inline void CountedUniformMatrix4fv(GLint location, GLsizei count, GLboolean transpose, const GLfloat* value)
+{
+    GlCounters().frame.uniformSets++;
+    glad_glUniformMatrix4fv(location, count, transpose, value);
+}
+
+// uploads; orphaning with NULL data counts as an upload of nothing
+inline void CountedBufferData(GLenum target, GLsizeiptr size, const void* data, GLenum usage)
+{
+    GlCounters().frame.uploads++;
+    GlCounters().frame.uploadBytes += data ? size : 0;
+    glad_glBufferData(target, size, data, usage);
+}
+
+inline void CountedBufferSubData(GLenum target, GLintptr offset, GLsizeiptr size, const void* data)
+{
+    GlCounters().frame.uploads++;
+    GlCounters().frame.uploadBytes += size;
+    glad_glBufferSubData(target, offset, size, data);
+}
+
+inline void CountedTexImage2D(GLenum target, GLint level, GLint internalformat, GLsizei width, GLsizei height, GLint border, GLenum format, GLenum type, const void* pixels)
+{
+    GlCounters().frame.uploads++;
+    GlCounters().frame.uploadBytes += pixels ? GlPixelBytes(format, type, width, height) : 0;
+    glad_glTexImage2D(target, level, internalformat, width, height, border, format, type, pixels);
+}
+
+// object creation
+inline void CountedGenBuffers(GLsizei n, GLuint* buffers)
+{
+    GlCounters().frame.objectsCreated += n;
+    glad_glGenBuffers(n, buffers);
+}
+
+inline void CountedGenVertexArrays(GLsizei n, GLuint* arrays)
+{
+    GlCounters().frame.objectsCreated += n;
+    glad_glGenVertexArrays(n, arrays);
+}
+
+inline void CountedGenTextures(GLsizei n, GLuint* textures)
+{
+    GlCounters().frame.objectsCreated += n;
+    glad_glGenTextures(n, textures);
+}
+
+inline void CountedGenFramebuffers(GLsizei n, GLuint* framebuffers)
+{
+    GlCounters().frame.objectsCreated += n;
+    glad_glGenFramebuffers(n, framebuffers);
+}
+
+inline GLuint CountedCreateProgram()
+{
+    GlCounters().frame.objectsCreated++;
+    return glad_glCreateProgram();
+}
+
+// other state
+inline void CountedEnable(GLenum cap)
+{
+    GlCounters().frame.stateChanges++;
+    glad_glEnable(cap);
+}
+
+inline void CountedDisable(GLenum cap)
+{
+    GlCounters().frame.stateChanges++;
+    glad_glDisable(cap);
+}
+
+inline void CountedDepthMask(GLboolean flag)
+{
+    GlCounters().frame.stateChanges++;
+    glad_glDepthMask(flag);
+}
+
+inline void CountedColorMask(GLboolean red, GLboolean green, GLboolean blue, GLboolean alpha)
+{
+    GlCounters().frame.stateChanges++;
+    glad_glColorMask(red, green, blue, alpha);
+}
+
+inline void CountedViewport(GLint x, GLint y, GLsizei width, GLsizei height)
+{
+    GlCounters().frame.stateChanges++;
+    glad_glViewport(x, y, width, height);
+}
+
+// glad declares every entry point as a macro over its function pointer; these take over
+// the names for everything compiled after this point
+#undef glDrawArrays
+#define glDrawArrays CountedDrawArrays
+#undef glDrawElements
+#define glDrawElements CountedDrawElements
+#undef glBindVertexArray
+#define glBindVertexArray CountedBindVertexArray
+#undef glBindBuffer
+#define glBindBuffer CountedBindBuffer
+#undef glBindBufferRange
+#define glBindBufferRange CountedBindBufferRange
+#undef glBindBufferBase
+#define glBindBufferBase CountedBindBufferBase
+#undef glActiveTexture
+#define glActiveTexture CountedActiveTexture
+#undef glBindTexture
+#define glBindTexture CountedBindTexture
+#undef glBindFramebuffer
+#define glBindFramebuffer CountedBindFramebuffer
+#undef glUseProgram
+#define glUseProgram CountedUseProgram
+#undef glUniform1i
+#define glUniform1i CountedUniform1i
+#undef glUniform1f
+#define glUniform1f CountedUniform1f
+#undef glUniform2fv
+#define glUniform2fv CountedUniform2fv
+#undef glUniform3f
+#define glUniform3f CountedUniform3f
+#undef glUniform3fv
+#define glUniform3fv CountedUniform3fv
+#undef glUniform4fv
+#define glUniform4fv CountedUniform4fv
+#undef glUniformMatrix3fv
+#define glUniformMatrix3fv CountedUniformMatrix3fv
+#undef glUniformMatrix4fv
+#define glUniformMatrix4fv CountedUniformMatrix4fv
+#undef glBufferData
+#define glBufferData CountedBufferData
+#undef glBufferSubData
+#define glBufferSubData CountedBufferSubData
+#undef glTexImage2D
+#define glTexImage2D CountedTexImage2D
+#undef glGenBuffers
+#define glGenBuffers CountedGenBuffers
+#undef glGenVertexArrays
+#define glGenVertexArrays CountedGenVertexArrays
+#undef glGenTextures
+#define glGenTextures CountedGenTextures
+#undef glGenFramebuffers
+#define glGenFramebuffers CountedGenFramebuffers
+#undef glCreateProgram
+#define glCreateProgram CountedCreateProgram
+#undef glEnable
+#define glEnable CountedEnable
+#undef glDisable
+#define glDisable CountedDisable
+#undef glDepthMask
+#define glDepthMask CountedDepthMask
+#undef glColorMask
+#define glColorMask CountedColorMask
+#undef glViewport
+#define glViewport CountedViewport
+
+#define GL_COUNT_MAPPED_BYTES(bytes) (GlCounters().mappedBytes += static_cast<unsigned long long>(bytes))
+#define GL_COUNTERS_END_FRAME() GlCounters().EndFrame()
+
+#else
+
+#define GL_COUNT_MAPPED_BYTES(bytes) ((void)0)
+#define GL_COUNTERS_END_FRAME() ((void)0)
+
+#endif
+#endif
@@ -0,0 +1,274 @@
+#ifndef GL_HANDLES_H
+#define GL_HANDLES_H
+
+#include <glad/glad.h>
+
+#include <vector>
+
+#include "gpu_memory.h"
+
+// Hands out GL names of one kind, generated BATCH at a time. Buffers and vertex arrays
+// given back are reset and handed out again before new names are generated: a buffer is
+// shrunk to nothing, a vertex array has its attributes disabled and its index buffer
+// unbound. Textures are deleted instead, since a recycled texture would keep the storage
+// of every mip level until each was specified again.
+class GlNamePool
+{
+public:
+    static const unsigned int BATCH = 32;
+    static const unsigned int MAX_FREE = 256;   // names beyond this are deleted on release
+
+    explicit GlNamePool(GpuResource kind)
+        : kind(kind)
+    {
+    }
+
+    GlNamePool(const GlNamePool&) = delete;
+    GlNamePool& operator=(const GlNamePool&) = delete;
+
+    unsigned int Acquire()
+    {
+        if (free.empty())
+            Generate();
+        unsigned int name = free.back();
+        free.pop_back();
+        return name;
+    }
+
+    void Release(unsigned int name)
+    {
+        GpuMemory().Free(kind, name);
+        if (shutDown)
+            return;     // the context, and the name with it, is already gone
+        if (kind == GpuResource::Texture || free.size() >= MAX_FREE)
+        {
+            Delete(1, &name);
+            return;
+        }
+        Reset(name);
+        free.push_back(name);
+        recycled++;
+    }
+
+    // deletes the spare names; handles released after this only drop their records.
+    // Call while the context is still current.
+    void Shutdown()
+    {
+        if (!free.empty())
+            Delete(static_cast<GLsizei>(free.size()), free.data());
+        free.clear();
+        shutDown = true;
+    }
+
+    unsigned int Generated() const
+    {
+        return generated;
+    }
+
+    unsigned int Recycled() const
+    {
+        return recycled;
+    }
+
+private:
+    GpuResource kind;
+    std::vector<unsigned int> free;
+    unsigned int generated = 0;
+    unsigned int recycled = 0;
+    GLint maxAttributes = 0;
+    bool shutDown = false;
+
+    void Generate()
+    {
+        unsigned int names[BATCH];
+        if (kind == GpuResource::Buffer)
+            glGenBuffers(BATCH, names);
+        else if (kind == GpuResource::VertexArray)
+            glGenVertexArrays(BATCH, names);
+        else
+            glGenTextures(BATCH, names);
+        // handed out lowest first, as one-off glGen* calls would have
+        for (unsigned int i = BATCH; i > 0; i--)
+            free.push_back(names[i - 1]);
+        generated += BATCH;
+    }
+
+    void Delete(GLsizei count, const unsigned int* names)
+    {
+        if (kind == GpuResource::Buffer)
+            glDeleteBuffers(count, names);
+        else if (kind == GpuResource::VertexArray)
+            glDeleteVertexArrays(count, names);
+        else
+            glDeleteTextures(count, names);
+    }
+
+    // the copy-write binding point and vertex array 0 are what the scene leaves bound anyway
+    void Reset(unsigned int name)
+    {
+        if (kind == GpuResource::Buffer)
+        {
+            glBindBuffer(GL_COPY_WRITE_BUFFER, name);
+            glBufferData(GL_COPY_WRITE_BUFFER, 0, NULL, GL_STATIC_DRAW);
+            glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+            return;
+        }
+        if (maxAttributes == 0)
+            glGetIntegerv(GL_MAX_VERTEX_ATTRIBS, &maxAttributes);
+        glBindVertexArray(name);
+        for (GLint i = 0; i < maxAttributes; i++)
+            glDisableVertexAttribArray(i);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+        glBindVertexArray(0);
+    }
+};
+
+struct GlNamePools
+{
+    GlNamePool buffers{ GpuResource::Buffer };
+    GlNamePool vertexArrays{ GpuResource::VertexArray };
+    GlNamePool textures{ GpuResource::Texture };
+
+    void Shutdown()
+    {
+        buffers.Shutdown();
+        vertexArrays.Shutdown();
+        textures.Shutdown();
+    }
+};
+
+inline GlNamePools& GlPools()
+{
+    static GlNamePools pools;
+    return pools;
+}
+
+// A GL name that goes back to its pool when the handle is destroyed or reset. Move-only;
+// converts to the plain name so it can be passed straight to GL calls.
+//   GlBuffer vbo(GlPools().buffers);
+template <GpuResource Kind>
+class GlHandle
+{
+public:
+    GlHandle() = default;
+
+    explicit GlHandle(GlNamePool& pool)
+        : pool(&pool), name(pool.Acquire())
+    {
+    }
+
+    ~GlHandle()
+    {
+        Reset();
+    }
+
+    GlHandle(GlHandle&& other)
+        : pool(other.pool), name(other.name)
+    {
+        other.name = 0;
+    }
+
+    GlHandle& operator=(GlHandle&& other)
+    {
+        if (this != &other)
+        {
+            Reset();
+            pool = other.pool;
+            name = other.name;
+            other.name = 0;
+        }
+        return *this;
+    }
+
+    GlHandle(const GlHandle&) = delete;
+    GlHandle& operator=(const GlHandle&) = delete;
+
+    unsigned int Name() const
+    {
+        return name;
+    }
+
+    operator unsigned int() const
+    {
+        return name;
+    }
+
+    void Reset()
+    {
+        if (pool && name)
+            pool->Release(name);
+        name = 0;
+    }
+
+    // gives up ownership; the caller deletes the name
+    unsigned int Release()
+    {
+        unsigned int released = name;
+        name = 0;
+        return released;
+    }
+
+private:
+    GlNamePool* pool = NULL;
+    unsigned int name = 0;
+};
+
+typedef GlHandle<GpuResource::Buffer> GlBuffer;
+typedef GlHandle<GpuResource::VertexArray> GlVertexArray;
+typedef GlHandle<GpuResource::Texture> GlTexture;
+
+// A program object, deleted with the handle. Programs are created one at a time by GL,
+// so there is nothing to pool.
+class GlProgram
+{
+public:
+    GlProgram() = default;
+
+    static GlProgram Create()
+    {
+        GlProgram program;
+        program.name = glCreateProgram();
+        return program;
+    }
+
+    ~GlProgram()
+    {
+        if (name)
+            glDeleteProgram(name);
+    }
+
+    GlProgram(GlProgram&& other)
+        : name(other.name)
+    {
+        other.name = 0;
+    }
+
+    GlProgram& operator=(GlProgram&& other)
+    {
+        if (this != &other)
+        {
+            if (name)
+                glDeleteProgram(name);
+            name = other.name;
+            other.name = 0;
+        }
+        return *this;
+    }
+
+    GlProgram(const GlProgram&) = delete;
+    GlProgram& operator=(const GlProgram&) = delete;
+
+    unsigned int Name() const
+    {
+        return name;
+    }
+
+    operator unsigned int() const
+    {
+        return name;
+    }
+
+private:
+    unsigned int name = 0;
+};
+#endif
@@ -0,0 +1,234 @@
+#ifndef GPU_MEMORY_H
+#define GPU_MEMORY_H
+
+#include <glad/glad.h>
+
+#include <cstdio>
+#include <iostream>
+#include <map>
+#include <string>
+#include <utility>
+
+enum class GpuResource
+{
+    Texture,
+    Buffer,
+    VertexArray,
+    Renderbuffer,
+};
+
+inline const char* GpuResourceName(GpuResource kind)
+{
+    switch (kind)
+    {
+    case GpuResource::Texture:
+        return "texture";
+    case GpuResource::Buffer:
+        return "buffer";
+    case GpuResource::VertexArray:
+        return "vertex array";
+    default:
+        return "renderbuffer";
+    }
+}
+
+// Keeps a record of every GL texture, buffer, vertex array and renderbuffer the scene
+// owns: its size as allocated, a short description of the format and the tag of the
+// code that owns it. The sizes are what was asked for; the driver may pad them. GL thread
+// only, like the calls it mirrors.
+class GpuMemoryTracker
+{
+public:
+    // warn once the total goes over this many bytes; 0 never warns
+    void SetBudget(std::size_t bytes)
+    {
+        budget = bytes;
+    }
+
+    // records a new object, or replaces the record of one whose storage was specified again
+    void Allocate(GpuResource kind, unsigned int name, std::size_t bytes, const std::string& format, const char* owner)
+    {
+        Record& record = records[Key(kind, name)];
+        total -= record.bytes;
+        record = Record{ bytes, format, owner };
+        total += bytes;
+        CheckBudget(record);
+    }
+
+    // changes the size of an existing record and nothing else, so it never allocates;
+    // unknown objects are ignored
+    void Resize(GpuResource kind, unsigned int name, std::size_t bytes)
+    {
+        auto it = records.find(Key(kind, name));
+        if (it == records.end())
+            return;
+        total = total - it->second.bytes + bytes;
+        it->second.bytes = bytes;
+        CheckBudget(it->second);
+    }
+
+    void Free(GpuResource kind, unsigned int name)
+    {
+        auto it = records.find(Key(kind, name));
+        if (it == records.end())
+            return;
+        total -= it->second.bytes;
+        records.erase(it);
+        if (total <= budget)
+            overBudget = false;
+    }
+
+    std::size_t TotalBytes() const
+    {
+        return total;
+    }
+
+    // totals by kind and by owner
+    void Report() const
+    {
+        std::map<std::string, Total> byKind, byOwner;
+        for (const auto& entry : records)
+        {
+            Add(byKind[GpuResourceName(entry.first.first)], entry.second.bytes);
+            Add(byOwner[entry.second.owner], entry.second.bytes);
+        }
+        std::cout << "GPU memory: " << Megabytes(total) << " MB in " << records.size() << " objects";
+        if (budget > 0)
+            std::cout << ", budget " << Megabytes(budget) << " MB";
+        std::cout << std::endl;
+        Print(byKind);
+        std::cout << "  by owner:" << std::endl;
+        Print(byOwner);
+    }
+
+    // lists everything still allocated; call after the scene has deleted what it owns.
+    // Returns true when nothing is left.
+    bool ReportLeaks() const
+    {
+        if (records.empty())
+        {
+            std::cout << "GPU memory: nothing leaked" << std::endl;
+            return true;
+        }
+        std::cout << "GPU memory: " << records.size() << " objects (" << Megabytes(total) << " MB) never deleted:" << std::endl;
+        for (const auto& entry : records)
+        {
+            char line[256];
+            std::snprintf(line, sizeof(line), "  %-12s %5u  %10zu bytes  %-24s %s", GpuResourceName(entry.first.first), entry.first.second, entry.second.bytes,
+                          entry.second.owner.c_str(), entry.second.format.c_str());
+            std::cout << line << std::endl;
+        }
+        return false;
+    }
+
+private:
+    typedef std::pair<GpuResource, unsigned int> ResourceKey;
+
+    struct Record
+    {
+        std::size_t bytes = 0;
+        std::string format;
+        std::string owner;
+    };
+
+    struct Total
+    {
+        unsigned int count = 0;
+        std::size_t bytes = 0;
+    };
+
+    std::map<ResourceKey, Record> records;
+    std::size_t total = 0;
+    std::size_t budget = 0;
+    bool overBudget = false;
+
+    void CheckBudget(const Record& changed)
+    {
+        if (budget > 0 && total > budget && !overBudget)
+        {
+            std::cout << "WARNING::GPU_MEMORY:: " << Megabytes(total) << " MB allocated, over the " << Megabytes(budget) << " MB budget ("
+                      << changed.owner << " " << changed.format << ")" << std::endl;
+            overBudget = true;
+        }
+        else if (total <= budget)
+        {
+            overBudget = false;
+        }
+    }
+
+    static ResourceKey Key(GpuResource kind, unsigned int name)
+    {
+        return ResourceKey(kind, name);
+    }
+
+    static double Megabytes(std::size_t bytes)
+    {
+        return bytes / (1024.0 * 1024.0);
+    }
+
+    static void Add(Total& sum, std::size_t bytes)
+    {
+        sum.count++;
+        sum.bytes += bytes;
+    }
+
+    static void Print(const std::map<std::string, Total>& totals)
+    {
+        for (const auto& entry : totals)
+        {
+            char line[160];
+            std::snprintf(line, sizeof(line), "  %-28s %5u %10.2f MB", entry.first.c_str(), entry.second.count, Megabytes(entry.second.bytes));
+            std::cout << line << std::endl;
+        }
+    }
+};
+
+inline GpuMemoryTracker& GpuMemory()
+{
+    static GpuMemoryTracker tracker;
+    return tracker;
+}
+
+// a 2D texture of width x height with components bytes per texel, plus its mip chain
+inline std::size_t TextureBytes(int width, int height, int components, bool mipmapped)
+{
+    std::size_t bytes = 0;
+    while (true)
+    {
+        bytes += static_cast<std::size_t>(width) * height * components;
+        if (!mipmapped || (width == 1 && height == 1))
+            return bytes;
+        width = width > 1 ? width / 2 : 1;
+        height = height > 1 ? height / 2 : 1;
+    }
+}
+
+// the delete calls with the record dropped first; the name is cleared
+inline void DeleteTexture(unsigned int& texture)
+{
+    GpuMemory().Free(GpuResource::Texture, texture);
+    glDeleteTextures(1, &texture);
+    texture = 0;
+}
+
+inline void DeleteBuffer(unsigned int& buffer)
+{
+    GpuMemory().Free(GpuResource::Buffer, buffer);
+    glDeleteBuffers(1, &buffer);
+    buffer = 0;
+}
+
+inline void DeleteVertexArray(unsigned int& vertexArray)
+{
+    GpuMemory().Free(GpuResource::VertexArray, vertexArray);
+    glDeleteVertexArrays(1, &vertexArray);
+    vertexArray = 0;
+}
+
+inline void DeleteRenderbuffer(unsigned int& renderbuffer)
+{
+    GpuMemory().Free(GpuResource::Renderbuffer, renderbuffer);
+    glDeleteRenderbuffers(1, &renderbuffer);
+    renderbuffer = 0;
+}
+#endif
@@ -0,0 +1,64 @@
+#ifndef IMAGE_FILE_H
+#define IMAGE_FILE_H
+
+#include <fstream>
+#include <string>
+#include <vector>
+
+// Writes RGB pixels, rows top to bottom, as an uncompressed 24-bit TGA, which every image
+// viewer and diff tool opens and which needs no library to write.
+inline bool WriteTga(const std::string& path, int width, int height, const std::vector<unsigned char>& rgb)
+{
+    std::ofstream file(path.c_str(), std::ios::binary | std::ios::trunc);
+    if (!file)
+        return false;
+    unsigned char header[18] = {};
+    header[2] = 2;      // uncompressed true color
+    header[12] = static_cast<unsigned char>(width & 0xff);
+    header[13] = static_cast<unsigned char>(width >> 8);
+    header[14] = static_cast<unsigned char>(height & 0xff);
+    header[15] = static_cast<unsigned char>(height >> 8);
+    header[16] = 24;
+    header[17] = 0x20;  // first row is the top one
+    file.write(reinterpret_cast<const char*>(header), sizeof(header));
+    std::vector<unsigned char> bgr(rgb.size());
+    for (std::size_t i = 0; i + 2 < rgb.size(); i += 3)
+    {
+        bgr[i] = rgb[i + 2];
+        bgr[i + 1] = rgb[i + 1];
+        bgr[i + 2] = rgb[i];
+    }
+    file.write(reinterpret_cast<const char*>(bgr.data()), static_cast<std::streamsize>(bgr.size()));
+    return file.good();
+}
+
+// Reads back a TGA as WriteTga writes it: uncompressed 24-bit, either row order. Other
+// variants are rejected.
+inline bool ReadTga(const std::string& path, int& width, int& height, std::vector<unsigned char>& rgb)
+{
+    std::ifstream file(path.c_str(), std::ios::binary);
+    unsigned char header[18];
+    if (!file.read(reinterpret_cast<char*>(header), sizeof(header)) || header[2] != 2 || header[16] != 24)
+        return false;
+    file.ignore(header[0]);     // image ID
+    width = header[12] | (header[13] << 8);
+    height = header[14] | (header[15] << 8);
+    std::vector<unsigned char> bgr(static_cast<std::size_t>(width) * height * 3);
+    if (!file.read(reinterpret_cast<char*>(bgr.data()), static_cast<std::streamsize>(bgr.size())))
+        return false;
+    const bool topFirst = (header[17] & 0x20) != 0;
+    rgb.resize(bgr.size());
+    for (int y = 0; y < height; y++)
+    {
+        const unsigned char* source = &bgr[static_cast<std::size_t>(topFirst ? y : height - 1 - y) * width * 3];
+        unsigned char* row = &rgb[static_cast<std::size_t>(y) * width * 3];
+        for (int x = 0; x < width * 3; x += 3)
+        {
+            row[x] = source[x + 2];
+            row[x + 1] = source[x + 1];
+            row[x + 2] = source[x];
+        }
+    }
+    return true;
+}
+#endif
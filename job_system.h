@@ -0,0 +1,307 @@
+#ifndef JOB_SYSTEM_H
+#define JOB_SYSTEM_H
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// A small work-stealing thread pool. Every worker owns a queue: it pops its own newest
+// job and, when that runs dry, steals the oldest job from another worker. Threads that
+// wait for work to finish (including the main thread) execute queued jobs meanwhile,
+// so jobs may safely wait on jobs they submitted.
+//
+// Queues keep their storage and the jobs the pool makes itself capture no more than a
+// std::function holds inline, so once the queues have grown to the busiest frame's
+// size, submitting and running jobs no longer touches the heap.
+class JobSystem
+{
+public:
+    typedef std::function<void()> Job;
+
+    // workers == 0 uses one thread per core, leaving one core for the GL thread
+    explicit JobSystem(unsigned int workers = 0)
+    {
+        if (workers == 0)
+        {
+            unsigned int cores = std::thread::hardware_concurrency();
+            workers = cores > 1 ? cores - 1 : 1;
+        }
+        for (unsigned int i = 0; i < workers; i++)
+            queues.emplace_back(new WorkQueue());
+        for (unsigned int i = 0; i < workers; i++)
+            threads.emplace_back(&JobSystem::WorkerLoop, this, i);
+    }
+
+    ~JobSystem()
+    {
+        {
+            std::lock_guard<std::mutex> lock(sleepMutex);
+            running = false;
+        }
+        wake.notify_all();
+        for (auto& thread : threads)
+            thread.join();
+    }
+
+    JobSystem(const JobSystem&) = delete;
+    JobSystem& operator=(const JobSystem&) = delete;
+
+    unsigned int WorkerCount() const
+    {
+        return static_cast<unsigned int>(threads.size());
+    }
+
+    // workers push onto their own queue, other threads spread jobs round-robin
+    void Submit(Job job)
+    {
+        unsigned int target = currentWorker() >= 0 ? static_cast<unsigned int>(currentWorker()) : nextQueue++ % WorkerCount();
+        {
+            std::lock_guard<std::mutex> lock(queues[target]->mutex);
+            queues[target]->jobs.push_back(std::move(job));
+        }
+        pending++;
+        {
+            // taking the lock orders this wake-up after a worker's check of pending
+            std::lock_guard<std::mutex> lock(sleepMutex);
+        }
+        wake.notify_one();
+    }
+
+    // runs one queued job on the calling thread; returns false if there was nothing to do
+    bool RunOne()
+    {
+        Job job;
+        if (!Take(job))
+            return false;
+        job();
+        return true;
+    }
+
+    // blocks until counter reaches zero, executing other jobs while it waits
+    void Wait(const std::atomic<int>& counter)
+    {
+        while (counter.load() > 0)
+        {
+            if (!RunOne())
+                std::this_thread::yield();
+        }
+    }
+
+    // calls fn(begin, end) over [0, count) in chunks spread across the workers
+    template <class Fn>
+    void ParallelFor(unsigned int count, unsigned int chunk, const Fn& fn)
+    {
+        if (count == 0)
+            return;
+        if (chunk == 0)
+            chunk = 1;
+        struct Loop
+        {
+            const Fn& fn;
+            std::atomic<int> remaining;
+        } loop{ fn, { static_cast<int>((count + chunk - 1) / chunk) } };
+        Loop* shared = &loop;
+        for (unsigned int begin = 0; begin < count; begin += chunk)
+        {
+            unsigned int end = begin + chunk < count ? begin + chunk : count;
+            Submit([shared, begin, end]() {
+                shared->fn(begin, end);
+                shared->remaining--;
+            });
+        }
+        Wait(loop.remaining);
+    }
+
+private:
+    // A double-ended queue in one ring buffer that doubles when full and never shrinks
+    class JobQueue
+    {
+    public:
+        bool empty() const
+        {
+            return count == 0;
+        }
+
+        void push_back(Job&& job)
+        {
+            if (count == slots.size())
+                Grow();
+            slots[(head + count) % slots.size()] = std::move(job);
+            count++;
+        }
+
+        Job pop_back()
+        {
+            count--;
+            return Take((head + count) % slots.size());
+        }
+
+        Job pop_front()
+        {
+            std::size_t slot = head;
+            head = (head + 1) % slots.size();
+            count--;
+            return Take(slot);
+        }
+
+    private:
+        std::vector<Job> slots;
+        std::size_t head = 0;
+        std::size_t count = 0;
+
+        Job Take(std::size_t slot)
+        {
+            Job job = std::move(slots[slot]);
+            slots[slot] = nullptr;
+            return job;
+        }
+
+        void Grow()
+        {
+            std::vector<Job> grown(slots.empty() ? 256 : slots.size() * 2);
+            for (std::size_t i = 0; i < count; i++)
+                grown[i] = std::move(slots[(head + i) % slots.size()]);
+            slots.swap(grown);
+            head = 0;
+        }
+    };
+
+    struct WorkQueue
+    {
+        std::mutex mutex;
+        JobQueue jobs;
+    };
+
+    std::vector<std::unique_ptr<WorkQueue>> queues;
+    std::vector<std::thread> threads;
+    std::atomic<int> pending{ 0 };      // jobs sitting in a queue
+    std::atomic<unsigned int> nextQueue{ 0 };
+    std::mutex sleepMutex;
+    std::condition_variable wake;
+    bool running = true;
+
+    static int& currentWorker()
+    {
+        static thread_local int index = -1;
+        return index;
+    }
+
+    bool Take(Job& job)
+    {
+        const int self = currentWorker();
+        const unsigned int count = WorkerCount();
+        if (self >= 0)
+        {
+            WorkQueue& own = *queues[self];
+            std::lock_guard<std::mutex> lock(own.mutex);
+            if (!own.jobs.empty())
+            {
+                job = own.jobs.pop_back();
+                pending--;
+                return true;
+            }
+        }
+        // steal the oldest job from someone else
+        unsigned int start = self >= 0 ? static_cast<unsigned int>(self) + 1 : 0;
+        for (unsigned int i = 0; i < count; i++)
+        {
+            WorkQueue& victim = *queues[(start + i) % count];
+            std::lock_guard<std::mutex> lock(victim.mutex);
+            if (!victim.jobs.empty())
+            {
+                job = victim.jobs.pop_front();
+                pending--;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void WorkerLoop(unsigned int index)
+    {
+        currentWorker() = static_cast<int>(index);
+        for (;;)
+        {
+            if (RunOne())
+                continue;
+            std::unique_lock<std::mutex> lock(sleepMutex);
+            wake.wait(lock, [this]() { return !running || pending.load() > 0; });
+            if (!running)
+                return;
+        }
+    }
+};
+
+// A set of tasks with dependencies, rebuilt once and run every frame. A task is handed
+// to the job system as soon as everything it depends on has finished; Run() returns
+// when the whole graph is done.
+class TaskGraph
+{
+public:
+    typedef unsigned int Task;
+
+    Task Add(std::function<void()> fn)
+    {
+        nodes.emplace_back(new Node());
+        nodes.back()->fn = std::move(fn);
+        return static_cast<Task>(nodes.size() - 1);
+    }
+
+    // task will not start before dependency has finished
+    void DependsOn(Task task, Task dependency)
+    {
+        nodes[dependency]->dependents.push_back(task);
+        nodes[task]->dependencyCount++;
+    }
+
+    void Run(JobSystem& jobs)
+    {
+        RunState run{ this, jobs, { static_cast<int>(nodes.size()) } };
+        for (auto& node : nodes)
+            node->waitingOn = node->dependencyCount;
+        for (Task i = 0; i < nodes.size(); i++)
+        {
+            if (nodes[i]->dependencyCount == 0)
+                Schedule(&run, i);
+        }
+        jobs.Wait(run.remaining);
+    }
+
+private:
+    struct Node
+    {
+        std::function<void()> fn;
+        std::vector<Task> dependents;
+        int dependencyCount = 0;
+        std::atomic<int> waitingOn{ 0 };
+    };
+
+    // what the jobs of one Run() share; they capture a pointer to it and their task
+    struct RunState
+    {
+        TaskGraph* graph;
+        JobSystem& jobs;
+        std::atomic<int> remaining;
+    };
+
+    std::vector<std::unique_ptr<Node>> nodes;
+
+    static void Schedule(RunState* run, Task task)
+    {
+        run->jobs.Submit([run, task]() {
+            Node& node = *run->graph->nodes[task];
+            node.fn();
+            for (Task dependent : node.dependents)
+            {
+                if (--run->graph->nodes[dependent]->waitingOn == 0)
+                    Schedule(run, dependent);
+            }
+            run->remaining--;
+        });
+    }
+};
+#endif
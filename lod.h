@@ -0,0 +1,50 @@
+#ifndef LOD_H
+#define LOD_H
+
+#include <glm/glm.hpp>
+
+#include <cmath>
+#include <vector>
+
+// Fraction of the viewport height covered by a bounding sphere, for a perspective camera
+// with the given vertical field of view. 1 fills the screen top to bottom.
+inline float ProjectedSize(const glm::vec3& center, float radius, const glm::vec3& cameraPosition, float fovyRadians)
+{
+    float distance = glm::length(center - cameraPosition);
+    if (distance <= radius)
+        return 1.0f;
+    return radius / (distance * std::tan(fovyRadians * 0.5f));
+}
+
+// Picks a level of detail from projected size. Level 0 is the most detailed; level i + 1
+// is used once the size drops below thresholds[i]. A level only changes when the size is
+// a margin past the threshold, so objects sitting near one do not flicker between levels.
+class LodSelector
+{
+public:
+    LodSelector(const std::vector<float>& thresholds, float hysteresis = 0.15f)
+        : thresholds(thresholds), hysteresis(hysteresis)
+    {
+    }
+
+    unsigned int LevelCount() const
+    {
+        return static_cast<unsigned int>(thresholds.size()) + 1;
+    }
+
+    // the level for an object that was drawn at current last frame
+    int Select(float screenSize, int current) const
+    {
+        const int levels = static_cast<int>(thresholds.size());
+        while (current < levels && screenSize < thresholds[current] * (1.0f - hysteresis))
+            current++;
+        while (current > 0 && screenSize > thresholds[current - 1] * (1.0f + hysteresis))
+            current--;
+        return current;
+    }
+
+private:
+    std::vector<float> thresholds;   // descending screen sizes
+    float hysteresis;
+};
+#endif
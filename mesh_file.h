@@ -0,0 +1,285 @@
+#ifndef MESH_FILE_H
+#define MESH_FILE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// The .mesh container: everything a model needs, laid out so it can be used straight
+// from a memory-mapped file. A header at offset 0 is followed by four tables, each
+// starting on a MESH_FILE_ALIGNMENT boundary:
+//
+//   vertices   vertexCount * MeshFileVertex, interleaved in the scene's usual layout
+//   indices    indexCount * uint32
+//   submeshes  submeshCount * MeshFileSubmesh, ranges of the index table
+//   materials  materialCount * MeshFileMaterial
+//
+// All values are little-endian. tools/mesh_convert.cpp writes these files.
+const char MESH_FILE_MAGIC[4] = { 'C', 'M', 'S', 'H' };
+const std::uint32_t MESH_FILE_VERSION = 1;
+const std::uint64_t MESH_FILE_ALIGNMENT = 16;
+
+struct MeshFileVertex
+{
+    float position[3];
+    float normal[3];
+    float texCoords[2];
+};
+
+struct MeshFileHeader
+{
+    char magic[4];
+    std::uint32_t version;
+    std::uint32_t vertexCount;
+    std::uint32_t indexCount;
+    std::uint32_t submeshCount;
+    std::uint32_t materialCount;
+    std::uint64_t vertexOffset;
+    std::uint64_t indexOffset;
+    std::uint64_t submeshOffset;
+    std::uint64_t materialOffset;
+    float boundsMin[3];
+    float boundsMax[3];
+};
+
+struct MeshFileSubmesh
+{
+    std::uint32_t firstIndex;
+    std::uint32_t indexCount;
+    std::uint32_t material;
+    std::uint32_t reserved;
+};
+
+// texture paths are relative to the .mesh file and zero-terminated; empty means none
+struct MeshFileMaterial
+{
+    char diffuse[120];
+    char specular[120];
+    float shininess;
+    std::uint32_t reserved[3];
+};
+
+inline std::uint64_t MeshFileAlign(std::uint64_t offset)
+{
+    return (offset + MESH_FILE_ALIGNMENT - 1) / MESH_FILE_ALIGNMENT * MESH_FILE_ALIGNMENT;
+}
+
+// A read-only memory mapping of a whole file.
+class MappedFile
+{
+public:
+    MappedFile() = default;
+
+    ~MappedFile()
+    {
+        Close();
+    }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    bool Open(const char* path)
+    {
+        Close();
+#ifdef _WIN32
+        file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+        if (file == INVALID_HANDLE_VALUE)
+            return false;
+        LARGE_INTEGER fileSize;
+        if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart == 0)
+        {
+            Close();
+            return false;
+        }
+        mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+        if (!mapping)
+        {
+            Close();
+            return false;
+        }
+        data = static_cast<const char*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+        size = static_cast<std::size_t>(fileSize.QuadPart);
+#else
+        descriptor = open(path, O_RDONLY);
+        if (descriptor < 0)
+            return false;
+        struct stat info;
+        if (fstat(descriptor, &info) != 0 || info.st_size == 0)
+        {
+            Close();
+            return false;
+        }
+        void* view = mmap(NULL, static_cast<std::size_t>(info.st_size), PROT_READ, MAP_PRIVATE, descriptor, 0);
+        data = view == MAP_FAILED ? NULL : static_cast<const char*>(view);
+        size = static_cast<std::size_t>(info.st_size);
+#endif
+        if (!data)
+        {
+            Close();
+            return false;
+        }
+        return true;
+    }
+
+    void Close()
+    {
+#ifdef _WIN32
+        if (data)
+            UnmapViewOfFile(data);
+        if (mapping)
+            CloseHandle(mapping);
+        if (file != INVALID_HANDLE_VALUE)
+            CloseHandle(file);
+        mapping = NULL;
+        file = INVALID_HANDLE_VALUE;
+#else
+        if (data)
+            munmap(const_cast<char*>(data), size);
+        if (descriptor >= 0)
+            close(descriptor);
+        descriptor = -1;
+#endif
+        data = NULL;
+        size = 0;
+    }
+
+    const char* Data() const
+    {
+        return data;
+    }
+
+    std::size_t Size() const
+    {
+        return size;
+    }
+
+private:
+    const char* data = NULL;
+    std::size_t size = 0;
+#ifdef _WIN32
+    HANDLE file = INVALID_HANDLE_VALUE;
+    HANDLE mapping = NULL;
+#else
+    int descriptor = -1;
+#endif
+};
+
+// A .mesh file mapped into memory. Open() checks the header against the file size and
+// the tables against each other: submesh ranges and materials, index values and texture
+// paths. The tables are then used in place, without copying or parsing.
+class MeshFile
+{
+public:
+    bool Open(const char* path)
+    {
+        header = NULL;
+        if (!file.Open(path))
+        {
+            std::cout << "ERROR::MESH_FILE::OPEN_FAILED: " << path << std::endl;
+            return false;
+        }
+        const MeshFileHeader* candidate = reinterpret_cast<const MeshFileHeader*>(file.Data());
+        if (file.Size() < sizeof(MeshFileHeader) || std::memcmp(candidate->magic, MESH_FILE_MAGIC, 4) != 0 || candidate->version != MESH_FILE_VERSION)
+        {
+            std::cout << "ERROR::MESH_FILE::NOT_A_MESH_FILE: " << path << std::endl;
+            file.Close();
+            return false;
+        }
+        if (!TableFits(candidate->vertexOffset, candidate->vertexCount, sizeof(MeshFileVertex)) ||
+            !TableFits(candidate->indexOffset, candidate->indexCount, sizeof(std::uint32_t)) ||
+            !TableFits(candidate->submeshOffset, candidate->submeshCount, sizeof(MeshFileSubmesh)) ||
+            !TableFits(candidate->materialOffset, candidate->materialCount, sizeof(MeshFileMaterial)))
+        {
+            std::cout << "ERROR::MESH_FILE::TRUNCATED: " << path << std::endl;
+            file.Close();
+            return false;
+        }
+        header = candidate;
+        if (!TablesConsistent())
+        {
+            std::cout << "ERROR::MESH_FILE::CORRUPT: " << path << std::endl;
+            Close();
+            return false;
+        }
+        return true;
+    }
+
+    void Close()
+    {
+        header = NULL;
+        file.Close();
+    }
+
+    const MeshFileHeader& Header() const
+    {
+        return *header;
+    }
+
+    const MeshFileVertex* Vertices() const
+    {
+        return reinterpret_cast<const MeshFileVertex*>(file.Data() + header->vertexOffset);
+    }
+
+    const std::uint32_t* Indices() const
+    {
+        return reinterpret_cast<const std::uint32_t*>(file.Data() + header->indexOffset);
+    }
+
+    const MeshFileSubmesh* Submeshes() const
+    {
+        return reinterpret_cast<const MeshFileSubmesh*>(file.Data() + header->submeshOffset);
+    }
+
+    const MeshFileMaterial* Materials() const
+    {
+        return reinterpret_cast<const MeshFileMaterial*>(file.Data() + header->materialOffset);
+    }
+
+private:
+    MappedFile file;
+    const MeshFileHeader* header = NULL;
+
+    // what a draw trusts: every submesh inside the index table with a material that exists,
+    // every index naming a vertex, every texture path terminated inside its field
+    bool TablesConsistent() const
+    {
+        for (std::uint32_t i = 0; i < header->submeshCount; i++)
+        {
+            const MeshFileSubmesh& submesh = Submeshes()[i];
+            if (submesh.firstIndex > header->indexCount || submesh.indexCount > header->indexCount - submesh.firstIndex || submesh.material >= header->materialCount)
+                return false;
+        }
+        const std::uint32_t* indices = Indices();
+        for (std::uint32_t i = 0; i < header->indexCount; i++)
+        {
+            if (indices[i] >= header->vertexCount)
+                return false;
+        }
+        for (std::uint32_t i = 0; i < header->materialCount; i++)
+        {
+            const MeshFileMaterial& material = Materials()[i];
+            if (!std::memchr(material.diffuse, 0, sizeof(material.diffuse)) || !std::memchr(material.specular, 0, sizeof(material.specular)))
+                return false;
+        }
+        return true;
+    }
+
+    bool TableFits(std::uint64_t offset, std::uint32_t count, std::size_t elementSize) const
+    {
+        return offset % MESH_FILE_ALIGNMENT == 0 && offset <= file.Size() && count <= (file.Size() - offset) / elementSize;
+    }
+};
+#endif
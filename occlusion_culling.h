@@ -0,0 +1,172 @@
+#ifndef OCCLUSION_CULLING_H
+#define OCCLUSION_CULLING_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <vector>
+
+#include "gpu_memory.h"
+#include "render_list.h"
+#include "shader_permutations.h"
+#include "uniform_ring.h"
+
+// Occlusion culling without CPU readback. At the end of a frame every object that passed
+// the frustum test gets a GL_ANY_SAMPLES_PASSED query around a depth-tested draw of its
+// bounding box, so the query answers "was any of it visible against this frame's depth".
+// The next frame draws the object inside glBeginConditionalRender on that query; the GPU
+// skips the draw if no sample passed and, with GL_QUERY_NO_WAIT, simply draws it if the
+// result is not in yet. An object can therefore appear one frame late when it comes out
+// from behind the blackboard or a wall; Settled() tells whether a frame may have done so.
+class OcclusionCulling
+{
+public:
+    explicit OcclusionCulling(unsigned int objectCount)
+        : queries(objectCount), issued(objectCount, 0), boxOffsets(objectCount, UniformRing::NO_SPACE),
+          boxProgram(BoxVertexShader(), BoxFragmentShader())
+    {
+        glGenQueries(objectCount, queries.data());
+        boxProgram.Finish();
+        glUniformBlockBinding(boxProgram.ID, glGetUniformBlockIndex(boxProgram.ID, "Matrices"), MATRICES_BINDING);
+        glUniformBlockBinding(boxProgram.ID, glGetUniformBlockIndex(boxProgram.ID, "Object"), OBJECT_BINDING);
+
+        // a cube from -1 to 1, scaled by each object's radius
+        const float box[] = {
+            -1, -1, -1,  1, -1, -1,  1,  1, -1,  1,  1, -1, -1,  1, -1, -1, -1, -1,
+            -1, -1,  1,  1, -1,  1,  1,  1,  1,  1,  1,  1, -1,  1,  1, -1, -1,  1,
+            -1,  1,  1, -1,  1, -1, -1, -1, -1, -1, -1, -1, -1, -1,  1, -1,  1,  1,
+             1,  1,  1,  1,  1, -1,  1, -1, -1,  1, -1, -1,  1, -1,  1,  1,  1,  1,
+            -1, -1, -1,  1, -1, -1,  1, -1,  1,  1, -1,  1, -1, -1,  1, -1, -1, -1,
+            -1,  1, -1,  1,  1, -1,  1,  1,  1,  1,  1,  1, -1,  1,  1, -1,  1, -1,
+        };
+        glGenVertexArrays(1, &boxVAO);
+        glGenBuffers(1, &boxVBO);
+        glBindVertexArray(boxVAO);
+        glBindBuffer(GL_ARRAY_BUFFER, boxVBO);
+        glBufferData(GL_ARRAY_BUFFER, sizeof(box), box, GL_STATIC_DRAW);
+        GpuMemory().Allocate(GpuResource::VertexArray, boxVAO, 0, "1 attribute", "occlusion culling");
+        GpuMemory().Allocate(GpuResource::Buffer, boxVBO, sizeof(box), "GL_ARRAY_BUFFER static", "occlusion culling");
+        glEnableVertexAttribArray(0);
+        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
+        glBindVertexArray(0);
+    }
+
+    ~OcclusionCulling()
+    {
+        glDeleteQueries(static_cast<GLsizei>(queries.size()), queries.data());
+        DeleteVertexArray(boxVAO);
+        DeleteBuffer(boxVBO);
+    }
+
+    OcclusionCulling(const OcclusionCulling&) = delete;
+    OcclusionCulling& operator=(const OcclusionCulling&) = delete;
+
+    // the query to draw object index under, or 0 to draw it unconditionally; safe on worker threads
+    unsigned int QueryFor(unsigned int index, const SceneObject& object, const TransformSystem& transforms, const glm::vec3& cameraPosition) const
+    {
+        if (!issued[index] || CameraInsideBox(object, transforms, cameraPosition))
+            return 0;
+        return queries[index];
+    }
+
+    // call for every visible object while the frame's ring section is open; writes the
+    // matrix of the box its query draws. Safe on worker threads, one thread per index.
+    void PrepareQuery(unsigned int index, const SceneObject& object, const TransformSystem& transforms, const glm::vec3& cameraPosition, UniformRing& ring)
+    {
+        // never culled objects and ones the camera is inside are drawn regardless
+        boxOffsets[index] = UniformRing::NO_SPACE;
+        if (object.radius <= 0.0f || CameraInsideBox(object, transforms, cameraPosition))
+            return;
+        glm::mat4 box = glm::scale(ObjectModel(object, transforms), glm::vec3(object.radius));
+        boxOffsets[index] = ring.Push(&box, sizeof(glm::mat4));
+    }
+
+    // call on the GL thread after the frame's last draw; visible is the frustum test result
+    // per object. Returns the number of box draws.
+    unsigned int IssueQueries(const FrameVector<char>& visible, const UniformRing& ring, const glm::mat4& viewProjection)
+    {
+        // this frame drew under the queries issued last frame; they only hold for this
+        // frame if the camera has not moved since
+        settled = !queriesIssued || issuedAt == viewProjection;
+        issuedAt = viewProjection;
+        boxProgram.use();
+        glBindVertexArray(boxVAO);
+        unsigned int draws = 0;
+        glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+        glDepthMask(GL_FALSE);
+        for (unsigned int i = 0; i < issued.size(); i++)
+        {
+            issued[i] = visible[i] && boxOffsets[i] != UniformRing::NO_SPACE;
+            if (!issued[i])
+                continue;
+            glBindBufferRange(GL_UNIFORM_BUFFER, OBJECT_BINDING, ring.Buffer(), boxOffsets[i], sizeof(glm::mat4));
+            glBeginQuery(GL_ANY_SAMPLES_PASSED, queries[i]);
+            glDrawArrays(GL_TRIANGLES, 0, 36);
+            glEndQuery(GL_ANY_SAMPLES_PASSED);
+            draws++;
+        }
+        glDepthMask(GL_TRUE);
+        glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+        glBindVertexArray(0);
+        queriesIssued = draws > 0;
+        return draws;
+    }
+
+    // false when the last frame was drawn under queries from another camera pose and may
+    // be missing objects it uncovered; the next frame draws them
+    bool Settled() const
+    {
+        return settled;
+    }
+
+private:
+    std::vector<GLuint> queries;
+    std::vector<char> issued;
+    std::vector<GLintptr> boxOffsets;   // this frame's box matrices in the uniform ring
+    bool queriesIssued = false;
+    glm::mat4 issuedAt = glm::mat4(1.0f);
+    bool settled = true;
+    ShaderProgram boxProgram;
+    unsigned int boxVAO = 0;
+    unsigned int boxVBO = 0;
+
+    // a box the camera is in (or nearly, given the near plane) loses the faces that would pass
+    static bool CameraInsideBox(const SceneObject& object, const TransformSystem& transforms, const glm::vec3& cameraPosition)
+    {
+        const glm::mat4& model = ObjectModel(object, transforms);
+        float scale = glm::max(glm::length(glm::vec3(model[0])), glm::max(glm::length(glm::vec3(model[1])), glm::length(glm::vec3(model[2]))));
+        // the box corners sit radius * sqrt(3) from the center
+        return glm::length(cameraPosition - glm::vec3(model[3])) < object.radius * scale * 1.74f + 0.1f;
+    }
+
+    static std::string BoxVertexShader()
+    {
+        return "#version 330 core\n"
+               "layout (location = 0) in vec3 aPos;\n"
+               "layout (std140) uniform Matrices\n"
+               "{\n"
+               "    mat4 projection;\n"
+               "    mat4 view;\n"
+               "};\n"
+               "layout (std140) uniform Object\n"
+               "{\n"
+               "    mat4 model;\n"
+               "};\n"
+               "void main()\n"
+               "{\n"
+               "    gl_Position = projection * view * model * vec4(aPos, 1.0);\n"
+               "}\n";
+    }
+
+    static std::string BoxFragmentShader()
+    {
+        return "#version 330 core\n"
+               "out vec4 FragColor;\n"
+               "void main()\n"
+               "{\n"
+               "    FragColor = vec4(1.0);\n"
+               "}\n";
+    }
+};
+#endif
@@ -0,0 +1,187 @@
+#ifndef PORTAL_VISIBILITY_H
+#define PORTAL_VISIBILITY_H
+
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include "frame_arena.h"
+#include "frustum.h"
+
+// Cell and portal visibility. Rooms are cells (boxes), doors and windows are portals
+// (rectangles joining two cells). Each frame the camera's cell is visible, and so is every
+// cell seen through a chain of portals: a portal is clipped against the current view
+// volume, and the cell behind it is visited with the volume narrowed to the clipped
+// portal. Objects in cells that are not reached are not drawn at all. The clipped
+// polygons and narrowed volumes of the walk come from the frame arena when given one.
+class PortalVisibility
+{
+public:
+    static const int NO_CELL = -1;
+
+    int AddCell(const glm::vec3& boxMin, const glm::vec3& boxMax)
+    {
+        cells.push_back({ boxMin, boxMax, std::vector<int>() });
+        visible.push_back(1);
+        onPath.push_back(0);
+        return static_cast<int>(cells.size()) - 1;
+    }
+
+    // corners go round the opening in order, either way
+    void AddPortal(int cellA, int cellB, const glm::vec3 corners[4])
+    {
+        Portal portal = { { cellA, cellB }, { corners[0], corners[1], corners[2], corners[3] } };
+        cells[cellA].portals.push_back(static_cast<int>(portals.size()));
+        cells[cellB].portals.push_back(static_cast<int>(portals.size()));
+        portals.push_back(portal);
+    }
+
+    int CellCount() const
+    {
+        return static_cast<int>(cells.size());
+    }
+
+    int CellAt(const glm::vec3& point) const
+    {
+        for (unsigned int i = 0; i < cells.size(); i++)
+        {
+            const Cell& c = cells[i];
+            if (point.x >= c.boxMin.x && point.y >= c.boxMin.y && point.z >= c.boxMin.z &&
+                point.x <= c.boxMax.x && point.y <= c.boxMax.y && point.z <= c.boxMax.z)
+                return static_cast<int>(i);
+        }
+        return NO_CELL;
+    }
+
+    // A camera outside every cell sees all of them. Objects outside every cell are
+    // always treated as visible.
+    void Update(const glm::vec3& eye, const Frustum& frustum, FrameArena* arena = NULL)
+    {
+        int start = CellAt(eye);
+        std::fill(visible.begin(), visible.end(), start == NO_CELL ? 1 : 0);
+        visibleCount = start == NO_CELL ? CellCount() : 0;
+        if (start == NO_CELL)
+            return;
+        // near and far first; they stay on every narrowed volume
+        const int order[] = { 4, 5, 0, 1, 2, 3 };
+        Planes planes{ FrameAllocator<glm::vec4>(arena) };
+        planes.reserve(6);
+        for (int plane : order)
+            planes.push_back(frustum.planes[plane]);
+        Visit(start, eye, planes);
+    }
+
+    bool CellVisible(int cell) const
+    {
+        return cell == NO_CELL || visible[cell];
+    }
+
+    int VisibleCellCount() const
+    {
+        return visibleCount;
+    }
+
+private:
+    typedef FrameVector<glm::vec3> Polygon;
+    typedef FrameVector<glm::vec4> Planes;
+
+    struct Cell
+    {
+        glm::vec3 boxMin;
+        glm::vec3 boxMax;
+        std::vector<int> portals;
+    };
+
+    struct Portal
+    {
+        int cells[2];
+        glm::vec3 corners[4];
+    };
+
+    void Visit(int cell, const glm::vec3& eye, const Planes& planes)
+    {
+        if (!visible[cell])
+            visibleCount++;
+        visible[cell] = 1;
+        // a cell already on the path is not entered again, so the walk always ends
+        onPath[cell] = 1;
+        for (int index : cells[cell].portals)
+        {
+            const Portal& portal = portals[index];
+            int next = portal.cells[0] == cell ? portal.cells[1] : portal.cells[0];
+            if (onPath[next])
+                continue;
+            Polygon polygon(portal.corners, portal.corners + 4, planes.get_allocator());
+            for (const glm::vec4& plane : planes)
+            {
+                polygon = ClipPolygon(polygon, plane);
+                if (polygon.size() < 3)
+                    break;
+            }
+            if (polygon.size() < 3)
+                continue;
+            glm::vec3 portalNormal = glm::normalize(glm::cross(portal.corners[1] - portal.corners[0], portal.corners[2] - portal.corners[0]));
+            Visit(next, eye, NarrowedPlanes(eye, polygon, portalNormal, planes));
+        }
+        onPath[cell] = 0;
+    }
+
+    // Sutherland-Hodgman: the part of the polygon on the inner side of the plane
+    static Polygon ClipPolygon(const Polygon& polygon, const glm::vec4& plane)
+    {
+        Polygon clipped(polygon.get_allocator());
+        clipped.reserve(polygon.size() + 1);
+        for (unsigned int i = 0; i < polygon.size(); i++)
+        {
+            const glm::vec3& a = polygon[i];
+            const glm::vec3& b = polygon[(i + 1) % polygon.size()];
+            float da = glm::dot(glm::vec3(plane), a) + plane.w;
+            float db = glm::dot(glm::vec3(plane), b) + plane.w;
+            if (da >= 0.0f)
+                clipped.push_back(a);
+            if ((da >= 0.0f) != (db >= 0.0f))
+                clipped.push_back(a + (b - a) * (da / (da - db)));
+        }
+        return clipped;
+    }
+
+    // The view volume through a clipped portal: a plane through the eye and each edge of
+    // the opening, plus the near and far planes of the camera. With the eye standing in
+    // the opening the edge planes are meaningless, so the volume is kept as it was.
+    static Planes NarrowedPlanes(const glm::vec3& eye, const Polygon& polygon, const glm::vec3& portalNormal, const Planes& planes)
+    {
+        glm::vec3 center(0.0f);
+        for (const glm::vec3& corner : polygon)
+            center += corner;
+        center /= static_cast<float>(polygon.size());
+
+        if (std::abs(glm::dot(portalNormal, eye - center)) < 0.05f)
+            return planes;
+
+        Planes narrowed(planes.get_allocator());
+        narrowed.reserve(polygon.size() + 2);
+        narrowed.push_back(planes[0]);
+        narrowed.push_back(planes[1]);
+        for (unsigned int i = 0; i < polygon.size(); i++)
+        {
+            glm::vec3 normal = glm::cross(polygon[i] - eye, polygon[(i + 1) % polygon.size()] - eye);
+            float length = glm::length(normal);
+            if (length <= 1e-6f)
+                continue;
+            normal /= length;
+            if (glm::dot(normal, center - eye) < 0.0f)
+                normal = -normal;
+            narrowed.push_back(glm::vec4(normal, -glm::dot(normal, eye)));
+        }
+        return narrowed;
+    }
+
+    std::vector<Cell> cells;
+    std::vector<Portal> portals;
+    std::vector<char> visible;
+    std::vector<char> onPath;
+    int visibleCount = 0;
+};
+#endif
@@ -0,0 +1,194 @@
+#ifndef PROGRAM_CACHE_H
+#define PROGRAM_CACHE_H
+
+#include <glad/glad.h>
+
+#include <string>
+#include <vector>
+#include <fstream>
+#include <iostream>
+#include <cstdint>
+
+#ifdef _WIN32
+#include <direct.h>
+#else
+#include <sys/stat.h>
+#endif
+
+// Keeps linked programs on disk with glGetProgramBinary so a warm start can hand them
+// straight back to the driver with glProgramBinary instead of compiling GLSL. Entries
+// are named after a hash of the shader sources and record the driver they came from;
+// a different driver, an edited shader or a binary the driver refuses all count as a
+// miss, and the caller compiles from source and stores the result again.
+class ProgramCache
+{
+public:
+    explicit ProgramCache(const std::string& directory = "shader_cache")
+        : directory(directory)
+    {
+#ifdef GL_NUM_PROGRAM_BINARY_FORMATS
+        GLint formats = 0;
+        glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+        supported = GLAD_GL_ARB_get_program_binary && formats > 0;
+#endif
+        if (!supported)
+            return;
+        driver = GLString(GL_VENDOR) + "|" + GLString(GL_RENDERER) + "|" + GLString(GL_VERSION);
+#ifdef _WIN32
+        _mkdir(directory.c_str());
+#else
+        mkdir(directory.c_str(), 0755);
+#endif
+    }
+
+    bool Supported() const
+    {
+        return supported;
+    }
+
+    unsigned int Hits() const
+    {
+        return hits;
+    }
+
+    unsigned int Misses() const
+    {
+        return misses;
+    }
+
+    // call before glLinkProgram on programs that will be stored
+    void PrepareLink(unsigned int program) const
+    {
+#ifdef GL_PROGRAM_BINARY_RETRIEVABLE_HINT
+        if (supported)
+            glProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+#endif
+    }
+
+    // loads the cached binary for these sources into program; false means compile from source
+    bool Load(const std::string& vertexCode, const std::string& fragmentCode, unsigned int program)
+    {
+        if (!supported)
+            return false;
+#ifdef GL_NUM_PROGRAM_BINARY_FORMATS
+        std::ifstream file(Path(vertexCode, fragmentCode).c_str(), std::ios::binary);
+        std::uint32_t magic = 0;
+        std::uint32_t driverLength = 0;
+        if (file.read(reinterpret_cast<char*>(&magic), sizeof(magic)) && magic == MAGIC &&
+            file.read(reinterpret_cast<char*>(&driverLength), sizeof(driverLength)) && driverLength == driver.size())
+        {
+            std::string entryDriver(driverLength, '\0');
+            GLenum format = 0;
+            std::uint32_t length = 0;
+            if (file.read(&entryDriver[0], driverLength) && entryDriver == driver &&
+                file.read(reinterpret_cast<char*>(&format), sizeof(format)) &&
+                file.read(reinterpret_cast<char*>(&length), sizeof(length)) && length > 0 && length == BytesLeft(file))
+            {
+                std::vector<char> binary(length);
+                if (file.read(binary.data(), length))
+                {
+                    glProgramBinary(program, format, binary.data(), static_cast<GLsizei>(length));
+                    GLint success = 0;
+                    glGetProgramiv(program, GL_LINK_STATUS, &success);
+                    if (success)
+                    {
+                        hits++;
+                        return true;
+                    }
+                }
+            }
+        }
+#endif
+        misses++;
+        return false;
+    }
+
+    // writes a freshly linked program to the cache
+    void Store(const std::string& vertexCode, const std::string& fragmentCode, unsigned int program) const
+    {
+        if (!supported)
+            return;
+#ifdef GL_NUM_PROGRAM_BINARY_FORMATS
+        GLint length = 0;
+        glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+        if (length <= 0)
+            return;
+        std::vector<char> binary(length);
+        GLenum format = 0;
+        glGetProgramBinary(program, length, NULL, &format, binary.data());
+
+        std::ofstream file(Path(vertexCode, fragmentCode).c_str(), std::ios::binary | std::ios::trunc);
+        if (!file)
+        {
+            std::cout << "ERROR::PROGRAM_CACHE::WRITE_FAILED: " << Path(vertexCode, fragmentCode) << std::endl;
+            return;
+        }
+        std::uint32_t magic = MAGIC;
+        std::uint32_t driverLength = static_cast<std::uint32_t>(driver.size());
+        std::uint32_t binaryLength = static_cast<std::uint32_t>(length);
+        file.write(reinterpret_cast<const char*>(&magic), sizeof(magic));
+        file.write(reinterpret_cast<const char*>(&driverLength), sizeof(driverLength));
+        file.write(driver.data(), driverLength);
+        file.write(reinterpret_cast<const char*>(&format), sizeof(format));
+        file.write(reinterpret_cast<const char*>(&binaryLength), sizeof(binaryLength));
+        file.write(binary.data(), binaryLength);
+#endif
+    }
+
+private:
+    static const std::uint32_t MAGIC = 0x31425043;  // "CPB1"
+
+    std::string directory;
+    std::string driver;
+    bool supported = false;
+    unsigned int hits = 0;
+    unsigned int misses = 0;
+
+    // what is left of the file after the read position; a binary whose stated length
+    // disagrees is a truncated or corrupt entry, not a reason to allocate that much
+    static std::uint64_t BytesLeft(std::ifstream& file)
+    {
+        std::streampos position = file.tellg();
+        file.seekg(0, std::ios::end);
+        std::streampos end = file.tellg();
+        file.seekg(position);
+        if (position < 0 || end < position)
+            return 0;
+        return static_cast<std::uint64_t>(end - position);
+    }
+
+    static std::string GLString(GLenum name)
+    {
+        const GLubyte* value = glGetString(name);
+        return value ? reinterpret_cast<const char*>(value) : "";
+    }
+
+    // FNV-1a over both stages; the separator keeps "ab"+"c" and "a"+"bc" apart
+    static std::uint64_t Hash(const std::string& vertexCode, const std::string& fragmentCode)
+    {
+        std::uint64_t hash = 14695981039346656037ull;
+        auto mix = [&hash](const std::string& text) {
+            for (unsigned char c : text)
+            {
+                hash ^= c;
+                hash *= 1099511628211ull;
+            }
+            hash ^= 0xff;
+            hash *= 1099511628211ull;
+        };
+        mix(vertexCode);
+        mix(fragmentCode);
+        return hash;
+    }
+
+    std::string Path(const std::string& vertexCode, const std::string& fragmentCode) const
+    {
+        static const char digits[] = "0123456789abcdef";
+        std::uint64_t hash = Hash(vertexCode, fragmentCode);
+        std::string name(16, '0');
+        for (int i = 15; i >= 0; i--, hash >>= 4)
+            name[i] = digits[hash & 0xf];
+        return directory + "/" + name + ".bin";
+    }
+};
+#endif
@@ -0,0 +1,273 @@
+#ifndef REGRESSION_SUITE_H
+#define REGRESSION_SUITE_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "gpu_memory.h"
+#include "image_file.h"
+
+// a camera pose the suite renders from; yaw and pitch as in Camera
+struct RegressionPose
+{
+    const char* name;
+    glm::vec3 position;
+    float yaw;
+    float pitch;
+};
+
+const RegressionPose regressionPoses[] = {
+    { "front", glm::vec3(0.0f, 0.0f, 3.0f), -90.0f, 0.0f },
+    { "corner", glm::vec3(2.5f, 1.5f, 2.5f), -135.0f, -20.0f },
+    { "board", glm::vec3(0.0f, 0.5f, 0.5f), -90.0f, 5.0f },
+    { "above", glm::vec3(-2.0f, 2.5f, 0.0f), 0.0f, -45.0f },
+};
+
+// A fixed-size color/depth framebuffer the suite renders into, independent of the window
+// size, so every run produces images of the same dimensions.
+class OffscreenTarget
+{
+public:
+    OffscreenTarget(int width, int height)
+        : width(width), height(height)
+    {
+        glGenFramebuffers(1, &fbo);
+        glGenRenderbuffers(1, &colorBuffer);
+        glGenRenderbuffers(1, &depthBuffer);
+        glBindRenderbuffer(GL_RENDERBUFFER, colorBuffer);
+        glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, width, height);
+        glBindRenderbuffer(GL_RENDERBUFFER, depthBuffer);
+        glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, width, height);
+        glBindRenderbuffer(GL_RENDERBUFFER, 0);
+        GpuMemory().Allocate(GpuResource::Renderbuffer, colorBuffer, static_cast<std::size_t>(width) * height * 4, "RGBA8", "regression");
+        GpuMemory().Allocate(GpuResource::Renderbuffer, depthBuffer, static_cast<std::size_t>(width) * height * 4, "DEPTH24_STENCIL8", "regression");
+
+        glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+        glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, colorBuffer);
+        glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, depthBuffer);
+        if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+            std::cout << "ERROR::FRAMEBUFFER:: Regression target is not complete!" << std::endl;
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    }
+
+    ~OffscreenTarget()
+    {
+        DeleteRenderbuffer(depthBuffer);
+        DeleteRenderbuffer(colorBuffer);
+        glDeleteFramebuffers(1, &fbo);
+    }
+
+    OffscreenTarget(const OffscreenTarget&) = delete;
+    OffscreenTarget& operator=(const OffscreenTarget&) = delete;
+
+    int Width() const
+    {
+        return width;
+    }
+
+    int Height() const
+    {
+        return height;
+    }
+
+    void Bind()
+    {
+        glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+        glViewport(0, 0, width, height);
+    }
+
+    // RGB, rows top to bottom like WriteTga expects; GL returns them bottom up
+    std::vector<unsigned char> ReadPixels()
+    {
+        std::vector<unsigned char> flipped(static_cast<std::size_t>(width) * height * 3);
+        glBindFramebuffer(GL_READ_FRAMEBUFFER, fbo);
+        glPixelStorei(GL_PACK_ALIGNMENT, 1);
+        glReadPixels(0, 0, width, height, GL_RGB, GL_UNSIGNED_BYTE, flipped.data());
+        std::vector<unsigned char> rgb(flipped.size());
+        const std::size_t row = static_cast<std::size_t>(width) * 3;
+        for (int y = 0; y < height; y++)
+            std::copy(&flipped[(height - 1 - y) * row], &flipped[(height - 1 - y) * row] + row, &rgb[y * row]);
+        return rgb;
+    }
+
+private:
+    int width;
+    int height;
+    unsigned int fbo = 0;
+    unsigned int colorBuffer = 0;
+    unsigned int depthBuffer = 0;
+};
+
+// Structural similarity of the luma of two images of the same size, averaged over 8x8
+// windows: 1 for identical images, falling as structure, contrast or brightness differ.
+// Unlike a per-pixel difference it shrugs off a few pixels of rasterization noise along
+// edges but notices a missing object or a wrong light color.
+inline float LumaSsim(const std::vector<unsigned char>& a, const std::vector<unsigned char>& b, int width, int height)
+{
+    const int WINDOW = 8;
+    const float C1 = (0.01f * 255.0f) * (0.01f * 255.0f);
+    const float C2 = (0.03f * 255.0f) * (0.03f * 255.0f);
+    auto luma = [&](const std::vector<unsigned char>& rgb, std::size_t pixel) {
+        return 0.299f * rgb[pixel * 3] + 0.587f * rgb[pixel * 3 + 1] + 0.114f * rgb[pixel * 3 + 2];
+    };
+
+    double total = 0.0;
+    int windows = 0;
+    for (int y0 = 0; y0 + WINDOW <= height; y0 += WINDOW / 2)
+    {
+        for (int x0 = 0; x0 + WINDOW <= width; x0 += WINDOW / 2)
+        {
+            float sumA = 0.0f, sumB = 0.0f, sumAA = 0.0f, sumBB = 0.0f, sumAB = 0.0f;
+            for (int y = y0; y < y0 + WINDOW; y++)
+            {
+                for (int x = x0; x < x0 + WINDOW; x++)
+                {
+                    std::size_t pixel = static_cast<std::size_t>(y) * width + x;
+                    float la = luma(a, pixel), lb = luma(b, pixel);
+                    sumA += la;
+                    sumB += lb;
+                    sumAA += la * la;
+                    sumBB += lb * lb;
+                    sumAB += la * lb;
+                }
+            }
+            const float n = static_cast<float>(WINDOW * WINDOW);
+            float meanA = sumA / n, meanB = sumB / n;
+            float varA = sumAA / n - meanA * meanA;
+            float varB = sumBB / n - meanB * meanB;
+            float covariance = sumAB / n - meanA * meanB;
+            total += ((2.0f * meanA * meanB + C1) * (2.0f * covariance + C2)) / ((meanA * meanA + meanB * meanB + C1) * (varA + varB + C2));
+            windows++;
+        }
+    }
+    return windows > 0 ? static_cast<float>(total / windows) : 1.0f;
+}
+
+// Compares rendered images with the goldens in a directory and frame times with the
+// baseline.csv next to them. In update mode nothing is compared; the goldens and the
+// baseline are rewritten from this run instead. A missing golden or baseline entry fails
+// the run, so a new pose cannot slip in unchecked.
+class RegressionSuite
+{
+public:
+    RegressionSuite(const std::string& directory, bool update, float minSsim = 0.98f, float maxSlowdown = 1.25f)
+        : directory(directory), update(update), minSsim(minSsim), maxSlowdown(maxSlowdown)
+    {
+        std::ifstream file((directory + "/baseline.csv").c_str());
+        std::string line;
+        while (std::getline(file, line))
+        {
+            std::istringstream fields(line);
+            std::string name, cpu, gpu;
+            if (std::getline(fields, name, ',') && std::getline(fields, cpu, ',') && std::getline(fields, gpu) && name != "name")
+                baseline[name] = Timing{ std::atof(cpu.c_str()), std::atof(gpu.c_str()) };
+        }
+    }
+
+    void CheckImage(const std::string& name, const std::vector<unsigned char>& rgb, int width, int height)
+    {
+        const std::string golden = directory + "/" + name + ".tga";
+        if (update)
+        {
+            if (!WriteTga(golden, width, height, rgb))
+                Fail(name, "cannot write " + golden);
+            return;
+        }
+        int goldenWidth = 0, goldenHeight = 0;
+        std::vector<unsigned char> expected;
+        if (!ReadTga(golden, goldenWidth, goldenHeight, expected))
+        {
+            Fail(name, "no golden image " + golden);
+            return;
+        }
+        if (goldenWidth != width || goldenHeight != height)
+        {
+            Fail(name, "golden image is " + std::to_string(goldenWidth) + "x" + std::to_string(goldenHeight));
+            return;
+        }
+        float ssim = LumaSsim(expected, rgb, width, height);
+        if (ssim < minSsim)
+        {
+            // the actual image goes next to the golden for a side-by-side look
+            WriteTga(directory + "/" + name + "_actual.tga", width, height, rgb);
+            Fail(name, "SSIM " + std::to_string(ssim) + " below " + std::to_string(minSsim));
+        }
+    }
+
+    // median CPU and GPU milliseconds of a pose; a small absolute slack keeps sub-millisecond
+    // scenes from failing on timer noise
+    void CheckTiming(const std::string& name, double cpuMs, double gpuMs)
+    {
+        measured[name] = Timing{ cpuMs, gpuMs };
+        if (update)
+            return;
+        std::map<std::string, Timing>::const_iterator entry = baseline.find(name);
+        if (entry == baseline.end())
+        {
+            Fail(name, "no baseline timing");
+            return;
+        }
+        const double SLACK_MS = 0.1;
+        if (cpuMs > entry->second.cpuMs * maxSlowdown + SLACK_MS)
+            Fail(name, "CPU " + std::to_string(cpuMs) + " ms, baseline " + std::to_string(entry->second.cpuMs) + " ms");
+        if (gpuMs > entry->second.gpuMs * maxSlowdown + SLACK_MS)
+            Fail(name, "GPU " + std::to_string(gpuMs) + " ms, baseline " + std::to_string(entry->second.gpuMs) + " ms");
+    }
+
+    // writes the baseline in update mode and prints the result; true when everything passed
+    bool Finish()
+    {
+        if (update)
+        {
+            std::ofstream file((directory + "/baseline.csv").c_str(), std::ios::trunc);
+            file << "name,cpu_ms,gpu_ms\n";
+            for (const auto& entry : measured)
+                file << entry.first << "," << entry.second.cpuMs << "," << entry.second.gpuMs << "\n";
+            if (!file)
+                Fail("baseline", "cannot write " + directory + "/baseline.csv");
+        }
+        for (const auto& entry : measured)
+        {
+            char line[160];
+            std::snprintf(line, sizeof(line), "%-24s CPU %7.3f ms  GPU %7.3f ms", entry.first.c_str(), entry.second.cpuMs, entry.second.gpuMs);
+            std::cout << line << std::endl;
+        }
+        if (update)
+            std::cout << "Regression: wrote " << measured.size() << " goldens and the baseline to " << directory << std::endl;
+        else
+            std::cout << "Regression: " << measured.size() << " cases, " << failures << " failures" << std::endl;
+        return failures == 0;
+    }
+
+private:
+    struct Timing
+    {
+        double cpuMs;
+        double gpuMs;
+    };
+
+    void Fail(const std::string& name, const std::string& reason)
+    {
+        std::cout << "FAIL " << name << ": " << reason << std::endl;
+        failures++;
+    }
+
+    std::string directory;
+    bool update;
+    float minSsim;
+    float maxSlowdown;
+    std::map<std::string, Timing> baseline;
+    std::map<std::string, Timing> measured;
+    unsigned int failures = 0;
+};
+#endif
@@ -0,0 +1,145 @@
+#ifndef RENDER_LIST_H
+#define RENDER_LIST_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <vector>
+
+#include "frame_arena.h"
+#include "frustum.h"
+#include "lod.h"
+#include "transform_system.h"
+#include "uniform_ring.h"
+
+// objects such as the pens issue their own draw calls through a callback
+typedef void (*DrawCallback)(void* object);
+
+template <class T>
+void DrawObject(void* object)
+{
+    static_cast<T*>(object)->Draw();
+}
+
+// one draw in the scene description, authored once at startup
+struct SceneObject
+{
+    TransformSystem::Handle transform;
+    const glm::mat4* fixedModel;    // used instead of the transform when set (the pens)
+    unsigned int vao;
+    unsigned int texture;           // 0 keeps the current binding
+    unsigned int vertexCount;
+    int shader;                     // light cubes only: which cube shader draws it
+    float radius;                   // bounding sphere in local units, 0 = never culled
+    DrawCallback draw;              // replaces glDrawArrays when set
+    void* object;
+    const int* lodLevel = NULL;     // current level of the object's LOD group, NULL = no LOD
+    int lodMaxLevel = 0;            // drawn while that level is at most this
+    int cell = -1;                  // room for portal visibility, -1 = outside every room
+};
+
+// a draw recorded by the worker threads, ready for the GL thread to replay
+struct DrawCommand
+{
+    glm::mat4 model;
+    GLintptr uniformOffset;     // where the model matrix sits in the uniform ring
+    unsigned int occlusionQuery;    // last frame's occlusion query to draw under, 0 = always draw
+    unsigned int vao;
+    unsigned int texture;
+    unsigned int vertexCount;
+    int shader;
+    DrawCallback draw;
+    void* object;
+};
+
+// a frame's command list, built in the frame arena
+typedef FrameVector<DrawCommand> DrawList;
+
+inline const glm::mat4& ObjectModel(const SceneObject& object, const TransformSystem& transforms)
+{
+    return object.fixedModel ? *object.fixedModel : transforms.World(object.transform);
+}
+
+inline bool ObjectVisible(const SceneObject& object, const TransformSystem& transforms, const Frustum& frustum)
+{
+    if (object.lodLevel && *object.lodLevel > object.lodMaxLevel)
+        return false;
+    if (object.radius <= 0.0f)
+        return true;
+    const glm::mat4& model = ObjectModel(object, transforms);
+    float scale = glm::max(glm::length(glm::vec3(model[0])), glm::max(glm::length(glm::vec3(model[1])), glm::length(glm::vec3(model[2]))));
+    return frustum.IntersectsSphere(glm::vec3(model[3]), object.radius * scale);
+}
+
+// fraction of the viewport height the object's bounding sphere covers; objects without a
+// radius are taken to fill it
+inline float ObjectScreenSize(const SceneObject& object, const TransformSystem& transforms, const glm::vec3& cameraPosition, float fovyRadians)
+{
+    if (object.radius <= 0.0f)
+        return 1.0f;
+    const glm::mat4& model = ObjectModel(object, transforms);
+    float scale = glm::max(glm::length(glm::vec3(model[0])), glm::max(glm::length(glm::vec3(model[1])), glm::length(glm::vec3(model[2]))));
+    return ProjectedSize(glm::vec3(model[3]), object.radius * scale, cameraPosition, fovyRadians);
+}
+
+// Appends the draw for object to commands. Safe to call from worker threads: the model
+// matrix goes straight into the mapped ring. Returns false, leaving commands as it was,
+// when the ring is full; the ring reports that at the end of the frame.
+inline bool MakeCommand(const SceneObject& object, const TransformSystem& transforms, UniformRing& ring, DrawList& commands)
+{
+    DrawCommand command;
+    command.model = ObjectModel(object, transforms);
+    command.uniformOffset = ring.Push(&command.model, sizeof(glm::mat4));
+    if (command.uniformOffset == UniformRing::NO_SPACE)
+        return false;
+    command.occlusionQuery = 0;
+    command.vao = object.vao;
+    command.texture = object.texture;
+    command.vertexCount = object.vertexCount;
+    command.shader = object.shader;
+    command.draw = object.draw;
+    command.object = object.object;
+    commands.push_back(command);
+    return true;
+}
+
+// Draws a command list with the current program, binding each draw's model matrix
+// from the uniform ring and skipping redundant VAO and texture binds. Draws with an
+// occlusion query are skipped by the GPU if that query saw no samples. Returns the
+// number of draws submitted. Only the GL thread may call this.
+inline unsigned int ReplayCommands(const DrawList& commands, const UniformRing& ring)
+{
+    unsigned int boundVAO = 0;
+    unsigned int boundTexture = 0;
+    glActiveTexture(GL_TEXTURE0);
+    for (const DrawCommand& command : commands)
+    {
+        if (command.texture != 0 && command.texture != boundTexture)
+        {
+            glBindTexture(GL_TEXTURE_2D, command.texture);
+            boundTexture = command.texture;
+        }
+        glBindBufferRange(GL_UNIFORM_BUFFER, OBJECT_BINDING, ring.Buffer(), command.uniformOffset, sizeof(glm::mat4));
+        if (command.occlusionQuery)
+            glBeginConditionalRender(command.occlusionQuery, GL_QUERY_NO_WAIT);
+        if (command.draw)
+        {
+            command.draw(command.object);
+            boundVAO = 0;  // the callback binds its own vertex array
+        }
+        else
+        {
+            if (command.vao != boundVAO)
+            {
+                glBindVertexArray(command.vao);
+                boundVAO = command.vao;
+            }
+            glDrawArrays(GL_TRIANGLES, 0, command.vertexCount);
+        }
+        if (command.occlusionQuery)
+            glEndConditionalRender();
+    }
+    glBindVertexArray(0);
+    return static_cast<unsigned int>(commands.size());
+}
+#endif
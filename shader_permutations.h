@@ -0,0 +1,314 @@
+#ifndef SHADER_PERMUTATIONS_H
+#define SHADER_PERMUTATIONS_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <string>
+#include <fstream>
+#include <sstream>
+#include <iostream>
+#include <map>
+#include <memory>
+
+#include "gl_handles.h"
+#include "program_cache.h"
+#include "frame_profiler.h"
+
+// A linked program built from in-memory sources. Offers the same setters as Shader so
+// a specialized variant can be used wherever the scene used a Shader before. Given a
+// cache, a program linked on an earlier run is loaded as a binary instead.
+//
+// The constructor only submits the compile and link; nothing asks the driver for the
+// result until Finish(), so with GL_KHR_parallel_shader_compile several programs build
+// on driver threads while the caller gets on with other startup work.
+class ShaderProgram
+{
+public:
+    GlProgram ID;
+
+    ShaderProgram(const std::string& vertexCode, const std::string& fragmentCode, ProgramCache* cache = NULL)
+    {
+        ID = GlProgram::Create();
+        if (cache && cache->Load(vertexCode, fragmentCode, ID))
+            return;
+
+        const char* vShaderCode = vertexCode.c_str();
+        const char* fShaderCode = fragmentCode.c_str();
+        vertex = glCreateShader(GL_VERTEX_SHADER);
+        glShaderSource(vertex, 1, &vShaderCode, NULL);
+        glCompileShader(vertex);
+        fragment = glCreateShader(GL_FRAGMENT_SHADER);
+        glShaderSource(fragment, 1, &fShaderCode, NULL);
+        glCompileShader(fragment);
+        glAttachShader(ID, vertex);
+        glAttachShader(ID, fragment);
+        if (cache)
+            cache->PrepareLink(ID);
+        glLinkProgram(ID);
+
+        pending = true;
+        binaryCache = cache;
+        if (cache)
+        {
+            vertexSource = vertexCode;
+            fragmentSource = fragmentCode;
+        }
+    }
+
+    ~ShaderProgram()
+    {
+        if (pending)
+        {
+            glDeleteShader(vertex);
+            glDeleteShader(fragment);
+        }
+    }
+
+    // true once Finish() would not block; always true without GL_KHR_parallel_shader_compile
+    bool Ready() const
+    {
+#ifdef GL_COMPLETION_STATUS_KHR
+        if (pending && GLAD_GL_KHR_parallel_shader_compile)
+        {
+            GLint done = GL_TRUE;
+            glGetProgramiv(ID, GL_COMPLETION_STATUS_KHR, &done);
+            return done == GL_TRUE;
+        }
+#endif
+        return true;
+    }
+
+    // waits for the link, reports errors and hands the binary to the cache
+    void Finish()
+    {
+        if (!pending)
+            return;
+        pending = false;
+        checkCompileErrors(vertex, "VERTEX");
+        checkCompileErrors(fragment, "FRAGMENT");
+        checkCompileErrors(ID, "PROGRAM");
+        glDetachShader(ID, vertex);
+        glDetachShader(ID, fragment);
+        glDeleteShader(vertex);
+        glDeleteShader(fragment);
+
+        GLint linked = 0;
+        glGetProgramiv(ID, GL_LINK_STATUS, &linked);
+        if (binaryCache && linked)
+            binaryCache->Store(vertexSource, fragmentSource, ID);
+        vertexSource.clear();
+        fragmentSource.clear();
+    }
+
+    ShaderProgram(const ShaderProgram&) = delete;
+    ShaderProgram& operator=(const ShaderProgram&) = delete;
+
+    void use() const
+    {
+        glUseProgram(ID);
+    }
+    void setBool(const std::string& name, bool value) const
+    {
+        glUniform1i(glGetUniformLocation(ID, name.c_str()), (int)value);
+    }
+    void setInt(const std::string& name, int value) const
+    {
+        glUniform1i(glGetUniformLocation(ID, name.c_str()), value);
+    }
+    void setFloat(const std::string& name, float value) const
+    {
+        glUniform1f(glGetUniformLocation(ID, name.c_str()), value);
+    }
+    void setVec3(const std::string& name, const glm::vec3& value) const
+    {
+        glUniform3fv(glGetUniformLocation(ID, name.c_str()), 1, &value[0]);
+    }
+    void setVec3(const std::string& name, float x, float y, float z) const
+    {
+        glUniform3f(glGetUniformLocation(ID, name.c_str()), x, y, z);
+    }
+    void setMat4(const std::string& name, const glm::mat4& mat) const
+    {
+        glUniformMatrix4fv(glGetUniformLocation(ID, name.c_str()), 1, GL_FALSE, &mat[0][0]);
+    }
+    // the same for literal names, which skip building a std::string; names past the
+    // small-string limit ("spotLight.direction") would otherwise allocate on every call
+    void setInt(const char* name, int value) const
+    {
+        glUniform1i(glGetUniformLocation(ID, name), value);
+    }
+    void setFloat(const char* name, float value) const
+    {
+        glUniform1f(glGetUniformLocation(ID, name), value);
+    }
+    void setVec3(const char* name, const glm::vec3& value) const
+    {
+        glUniform3fv(glGetUniformLocation(ID, name), 1, &value[0]);
+    }
+    void setMat4(const char* name, const glm::mat4& mat) const
+    {
+        glUniformMatrix4fv(glGetUniformLocation(ID, name), 1, GL_FALSE, &mat[0][0]);
+    }
+
+private:
+    unsigned int vertex = 0;
+    unsigned int fragment = 0;
+    bool pending = false;
+    ProgramCache* binaryCache = NULL;
+    std::string vertexSource;   // kept until Finish() for the cache key
+    std::string fragmentSource;
+
+    void checkCompileErrors(GLuint shader, std::string type)
+    {
+        int success;
+        char infoLog[1024];
+        if (type != "PROGRAM")
+        {
+            glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
+            if (!success)
+            {
+                glGetShaderInfoLog(shader, 1024, NULL, infoLog);
+                std::cout << "ERROR::SHADER_COMPILATION_ERROR of type: " << type << "\n" << infoLog << std::endl;
+            }
+        }
+        else
+        {
+            glGetProgramiv(shader, GL_LINK_STATUS, &success);
+            if (!success)
+            {
+                glGetProgramInfoLog(shader, 1024, NULL, infoLog);
+                std::cout << "ERROR::PROGRAM_LINKING_ERROR of type: " << type << "\n" << infoLog << std::endl;
+            }
+        }
+    }
+};
+
+// compile-time switches of the lighting shader; each distinct set is one cached program
+struct LightingPermutation
+{
+    int pointLights;    // NR_POINT_LIGHTS, sizes the (unrolled) point light loop
+    int colorMode;      // LIGHT_COLOR_MODE: 0 = constant white, 1 = animated light color modes
+    bool shadows;       // SHADOWS: reserved, the scene has no shadow pass yet
+
+    std::map<std::string, int> Defines() const
+    {
+        std::map<std::string, int> defines;
+        defines["NR_POINT_LIGHTS"] = pointLights;
+        defines["LIGHT_COLOR_MODE"] = colorMode;
+        defines["SHADOWS"] = shadows ? 1 : 0;
+        return defines;
+    }
+};
+
+// Reads a vertex/fragment shader pair once and compiles a specialized program for every
+// set of #defines it is asked for. Each permutation is compiled the first time it is
+// requested and then served from the cache; call Finish() before relying on one.
+class ShaderPermutations
+{
+public:
+    ShaderPermutations(const char* vertexPath, const char* fragmentPath, ProgramCache* binaryCache = NULL)
+        : binaryCache(binaryCache)
+    {
+        vertexSource = ReadFile(vertexPath);
+        fragmentSource = ReadFile(fragmentPath);
+    }
+
+    // the shaders exactly as written, without extra defines
+    ShaderProgram& Get()
+    {
+        return Get(std::map<std::string, int>());
+    }
+
+    ShaderProgram& Get(const LightingPermutation& permutation)
+    {
+        return Get(permutation.Defines());
+    }
+
+    ShaderProgram& Get(const std::map<std::string, int>& defines)
+    {
+        std::string key = Key(defines);
+        auto it = programs.find(key);
+        if (it != programs.end())
+            return *it->second;
+
+        ProfileScope scope("submit program");
+        std::string header = Header(defines);
+        std::unique_ptr<ShaderProgram> program(new ShaderProgram(Inject(vertexSource, header), Inject(fragmentSource, header), binaryCache));
+        ShaderProgram& result = *program;
+        programs[key] = std::move(program);
+        return result;
+    }
+
+    // waits for every program submitted so far
+    void Finish()
+    {
+        for (auto& program : programs)
+            program.second->Finish();
+    }
+
+    // deletes every cached program; call while the GL context is still current
+    void Clear()
+    {
+        programs.clear();
+    }
+
+    unsigned int Count() const
+    {
+        return static_cast<unsigned int>(programs.size());
+    }
+
+private:
+    std::string vertexSource;
+    std::string fragmentSource;
+    ProgramCache* binaryCache;
+    std::map<std::string, std::unique_ptr<ShaderProgram>> programs;
+
+    static std::string ReadFile(const char* path)
+    {
+        std::ifstream file;
+        file.exceptions(std::ifstream::failbit | std::ifstream::badbit);
+        try
+        {
+            file.open(path);
+            std::stringstream stream;
+            stream << file.rdbuf();
+            file.close();
+            return stream.str();
+        }
+        catch (std::ifstream::failure& e)
+        {
+            std::cout << "ERROR::SHADER::FILE_NOT_SUCCESSFULLY_READ: " << path << " " << e.what() << std::endl;
+        }
+        return std::string();
+    }
+
+    static std::string Key(const std::map<std::string, int>& defines)
+    {
+        std::string key;
+        for (auto& define : defines)
+            key += define.first + "=" + std::to_string(define.second) + ";";
+        return key;
+    }
+
+    static std::string Header(const std::map<std::string, int>& defines)
+    {
+        std::string header;
+        for (auto& define : defines)
+            header += "#define " + define.first + " " + std::to_string(define.second) + "\n";
+        return header;
+    }
+
+    // the defines have to follow the #version line, which must stay first in the source
+    static std::string Inject(const std::string& source, const std::string& header)
+    {
+        std::size_t version = source.find("#version");
+        if (version == std::string::npos)
+            return header + source;
+        std::size_t lineEnd = source.find('\n', version);
+        if (lineEnd == std::string::npos)
+            return source + "\n" + header;
+        return source.substr(0, lineEnd + 1) + header + source.substr(lineEnd + 1);
+    }
+};
+#endif
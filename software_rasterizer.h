@@ -0,0 +1,487 @@
+#ifndef SOFTWARE_RASTERIZER_H
+#define SOFTWARE_RASTERIZER_H
+
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+#include "job_system.h"
+#include "specular_lighting.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define SOFTWARE_RASTERIZER_SSE 1
+#endif
+
+// A CPU copy of a texture with its mip chain, sampled like GL_LINEAR_MIPMAP_LINEAR with
+// GL_REPEAT, which is how uploadTexture sets up every texture in the scene.
+class SoftwareTexture
+{
+public:
+    SoftwareTexture(const unsigned char* data, int width, int height, int components)
+    {
+        Level base;
+        base.width = width;
+        base.height = height;
+        base.texels.resize(static_cast<std::size_t>(width) * height);
+        for (int i = 0; i < width * height; i++)
+        {
+            const unsigned char* texel = data + static_cast<std::size_t>(i) * components;
+            // GL_RED fills green and blue with 0, like the GL texture
+            base.texels[i] = components >= 3 ? glm::vec3(texel[0], texel[1], texel[2]) / 255.0f : glm::vec3(texel[0] / 255.0f, 0.0f, 0.0f);
+        }
+        levels.push_back(base);
+        // box-filtered halves, as glGenerateMipmap makes them
+        while (levels.back().width > 1 || levels.back().height > 1)
+        {
+            const Level& above = levels.back();
+            Level level;
+            level.width = std::max(1, above.width / 2);
+            level.height = std::max(1, above.height / 2);
+            level.texels.resize(static_cast<std::size_t>(level.width) * level.height);
+            for (int y = 0; y < level.height; y++)
+            {
+                for (int x = 0; x < level.width; x++)
+                {
+                    int x0 = std::min(2 * x, above.width - 1), x1 = std::min(2 * x + 1, above.width - 1);
+                    int y0 = std::min(2 * y, above.height - 1), y1 = std::min(2 * y + 1, above.height - 1);
+                    level.texels[y * level.width + x] = (above.At(x0, y0) + above.At(x1, y0) + above.At(x0, y1) + above.At(x1, y1)) * 0.25f;
+                }
+            }
+            levels.push_back(level);
+        }
+    }
+
+    int Width() const
+    {
+        return levels[0].width;
+    }
+
+    int Height() const
+    {
+        return levels[0].height;
+    }
+
+    // lod is log2 of texels per pixel, from the texture coordinate derivatives
+    glm::vec3 Sample(const glm::vec2& uv, float lod) const
+    {
+        lod = glm::clamp(lod, 0.0f, static_cast<float>(levels.size() - 1));
+        int level = static_cast<int>(lod);
+        float blend = lod - level;
+        glm::vec3 color = levels[level].Bilinear(uv);
+        if (blend > 0.0f && level + 1 < static_cast<int>(levels.size()))
+            color += (levels[level + 1].Bilinear(uv) - color) * blend;
+        return color;
+    }
+
+private:
+    struct Level
+    {
+        int width = 0;
+        int height = 0;
+        std::vector<glm::vec3> texels;
+
+        const glm::vec3& At(int x, int y) const
+        {
+            return texels[y * width + x];
+        }
+
+        // GL_LINEAR with GL_REPEAT; v = 0 is the first row, as glTexImage2D uploads it
+        glm::vec3 Bilinear(const glm::vec2& uv) const
+        {
+            float x = uv.x * width - 0.5f, y = uv.y * height - 0.5f;
+            float fx = std::floor(x), fy = std::floor(y);
+            float tx = x - fx, ty = y - fy;
+            int x0 = Wrap(static_cast<int>(fx), width), x1 = Wrap(static_cast<int>(fx) + 1, width);
+            int y0 = Wrap(static_cast<int>(fy), height), y1 = Wrap(static_cast<int>(fy) + 1, height);
+            glm::vec3 top = At(x0, y0) + (At(x1, y0) - At(x0, y0)) * tx;
+            glm::vec3 bottom = At(x0, y1) + (At(x1, y1) - At(x0, y1)) * tx;
+            return top + (bottom - top) * ty;
+        }
+
+        static int Wrap(int i, int size)
+        {
+            i %= size;
+            return i < 0 ? i + size : i;
+        }
+    };
+
+    std::vector<Level> levels;
+};
+
+// vertices as the scene's vertex tables hold them: position, normal and texture
+// coordinates (stride 8), or positions only (stride 3) for the light cubes
+struct SoftwareMesh
+{
+    const float* vertices;
+    unsigned int vertexCount;
+    unsigned int stride;
+};
+
+// one glDrawArrays of the scene: lit draws use specular.fs, the rest a flat color
+struct SoftwareDraw
+{
+    SoftwareMesh mesh;
+    glm::mat4 model;
+    const SoftwareTexture* diffuse;     // NULL samples black, like an unbound unit
+    const SoftwareTexture* specular;
+    bool lit;
+    glm::vec3 color;
+};
+
+// A reference renderer for machines without a GPU. Draws the scene's meshes with the
+// same transforms, textures and lighting model as the GL path, so its images can be
+// compared with GL output. The screen is cut into 64 x 64 tiles, each rasterized and
+// shaded by one worker: triangles are binned to the tiles they touch, rasterized four
+// pixels at a time into the tile's depth buffer, remembering only which triangle won each
+// pixel, and every pixel is then shaded once. Depth testing is GL_LESS, nothing is culled.
+class SoftwareRasterizer
+{
+public:
+    static const int TILE_SIZE = 64;
+
+    SoftwareRasterizer(int width, int height)
+        : width(width), height(height), tilesX((width + TILE_SIZE - 1) / TILE_SIZE), tilesY((height + TILE_SIZE - 1) / TILE_SIZE),
+          pixels(static_cast<std::size_t>(width) * height * 3)
+    {
+    }
+
+    int Width() const
+    {
+        return width;
+    }
+
+    int Height() const
+    {
+        return height;
+    }
+
+    // rows top to bottom, RGB
+    const std::vector<unsigned char>& Pixels() const
+    {
+        return pixels;
+    }
+
+    void Render(JobSystem& jobs, const std::vector<SoftwareDraw>& draws, const glm::mat4& projection, const glm::mat4& view,
+                const glm::vec3& viewPos, const glm::vec3& viewFront, const SpecularLighting& lighting, const glm::vec3& lightTint,
+                const glm::vec3& clearColor)
+    {
+        this->draws = &draws;
+        this->lighting = &lighting;
+        this->viewPos = viewPos;
+        this->viewFront = viewFront;
+        this->lightTint = lightTint;
+        this->clearColor = clearColor;
+
+        // vertex stage, one draw per job; each draw writes its own slice
+        std::vector<unsigned int> firstVertex(draws.size() + 1, 0);
+        for (unsigned int i = 0; i < draws.size(); i++)
+            firstVertex[i + 1] = firstVertex[i] + DrawVertexCount(draws[i]);
+        vertices.resize(firstVertex.back());
+        const glm::mat4 viewProjection = projection * view;
+        jobs.ParallelFor(static_cast<unsigned int>(draws.size()), 1, [&](unsigned int begin, unsigned int end) {
+            for (unsigned int i = begin; i < end; i++)
+                TransformVertices(draws[i], viewProjection, &vertices[firstVertex[i]]);
+        });
+
+        // clipping, setup and binning stay in submission order, so ties in depth are
+        // settled the way GL settles them
+        triangles.clear();
+        for (std::vector<unsigned int>& bin : bins)
+            bin.clear();
+        bins.resize(tilesX * tilesY);
+        for (unsigned int i = 0; i < draws.size(); i++)
+        {
+            for (unsigned int v = firstVertex[i]; v + 2 < firstVertex[i + 1]; v += 3)
+                ClipAndSetup(i, vertices[v], vertices[v + 1], vertices[v + 2]);
+        }
+
+        jobs.ParallelFor(static_cast<unsigned int>(tilesX * tilesY), 1, [&](unsigned int begin, unsigned int end) {
+            for (unsigned int tile = begin; tile < end; tile++)
+                RenderTile(tile);
+        });
+    }
+
+private:
+    struct Vertex
+    {
+        glm::vec4 clip;
+        glm::vec3 world;
+        glm::vec3 normal;
+        glm::vec2 uv;
+    };
+
+    // a screen-space triangle ready for the tiles
+    struct Triangle
+    {
+        unsigned int draw;
+        float edgeA[3], edgeB[3], edgeC[3];     // edge i is opposite vertex i: e = A x + B y + C
+        bool topLeft[3];
+        float z[3];
+        float invW[3];
+        float invArea;
+        Vertex vertex[3];
+        int minX, minY, maxX, maxY;
+    };
+
+    static unsigned int DrawVertexCount(const SoftwareDraw& draw)
+    {
+        return draw.mesh.vertexCount - draw.mesh.vertexCount % 3;
+    }
+
+    static void TransformVertices(const SoftwareDraw& draw, const glm::mat4& viewProjection, Vertex* out)
+    {
+        // the normal matrix, as specular.vs computes it
+        const glm::mat3 normalMatrix = glm::mat3(glm::transpose(glm::inverse(draw.model)));
+        const unsigned int stride = draw.mesh.stride;
+        for (unsigned int i = 0; i < DrawVertexCount(draw); i++)
+        {
+            const float* source = draw.mesh.vertices + i * stride;
+            Vertex& vertex = out[i];
+            vertex.world = glm::vec3(draw.model * glm::vec4(source[0], source[1], source[2], 1.0f));
+            vertex.clip = viewProjection * glm::vec4(vertex.world, 1.0f);
+            vertex.normal = stride >= 6 ? normalMatrix * glm::vec3(source[3], source[4], source[5]) : glm::vec3(0.0f);
+            vertex.uv = stride >= 8 ? glm::vec2(source[6], source[7]) : glm::vec2(0.0f);
+        }
+    }
+
+    static Vertex Lerp(const Vertex& a, const Vertex& b, float t)
+    {
+        Vertex v;
+        v.clip = a.clip + (b.clip - a.clip) * t;
+        v.world = a.world + (b.world - a.world) * t;
+        v.normal = a.normal + (b.normal - a.normal) * t;
+        v.uv = a.uv + (b.uv - a.uv) * t;
+        return v;
+    }
+
+    // Clips against the near plane (z > -w), which is the only plane that matters for
+    // projection; the others are left to the screen-space bounding box.
+    void ClipAndSetup(unsigned int draw, const Vertex& a, const Vertex& b, const Vertex& c)
+    {
+        const Vertex* input[3] = { &a, &b, &c };
+        Vertex polygon[4];
+        int count = 0;
+        for (int i = 0; i < 3; i++)
+        {
+            const Vertex& current = *input[i];
+            const Vertex& next = *input[(i + 1) % 3];
+            float dc = current.clip.z + current.clip.w, dn = next.clip.z + next.clip.w;
+            if (dc >= 0.0f)
+                polygon[count++] = current;
+            if ((dc >= 0.0f) != (dn >= 0.0f))
+                polygon[count++] = Lerp(current, next, dc / (dc - dn));
+        }
+        for (int i = 1; i + 1 < count; i++)
+            Setup(draw, polygon[0], polygon[i], polygon[i + 1]);
+    }
+
+    void Setup(unsigned int draw, const Vertex& a, const Vertex& b, const Vertex& c)
+    {
+        Triangle triangle;
+        triangle.draw = draw;
+        triangle.vertex[0] = a;
+        triangle.vertex[1] = b;
+        triangle.vertex[2] = c;
+        float x[3], y[3];
+        for (int i = 0; i < 3; i++)
+        {
+            const glm::vec4& clip = triangle.vertex[i].clip;
+            if (clip.w <= 0.0f)
+                return;
+            triangle.invW[i] = 1.0f / clip.w;
+            // rows run top to bottom, as the image is written
+            x[i] = (clip.x * triangle.invW[i] * 0.5f + 0.5f) * width;
+            y[i] = (0.5f - clip.y * triangle.invW[i] * 0.5f) * height;
+            triangle.z[i] = clip.z * triangle.invW[i] * 0.5f + 0.5f;
+        }
+        float area = (x[1] - x[0]) * (y[2] - y[0]) - (x[2] - x[0]) * (y[1] - y[0]);
+        if (area == 0.0f)
+            return;
+        // both windings are drawn; flip the edges so inside is positive either way
+        float sign = area > 0.0f ? 1.0f : -1.0f;
+        for (int i = 0; i < 3; i++)
+        {
+            int j = (i + 1) % 3, k = (i + 2) % 3;
+            triangle.edgeA[i] = sign * (y[j] - y[k]);
+            triangle.edgeB[i] = sign * (x[k] - x[j]);
+            triangle.edgeC[i] = sign * (x[j] * y[k] - x[k] * y[j]);
+            // top-left rule: pixels exactly on a shared edge belong to one triangle
+            triangle.topLeft[i] = triangle.edgeA[i] > 0.0f || (triangle.edgeA[i] == 0.0f && triangle.edgeB[i] < 0.0f);
+        }
+        triangle.invArea = 1.0f / std::abs(area);
+
+        float minX = std::min(x[0], std::min(x[1], x[2])), maxX = std::max(x[0], std::max(x[1], x[2]));
+        float minY = std::min(y[0], std::min(y[1], y[2])), maxY = std::max(y[0], std::max(y[1], y[2]));
+        triangle.minX = std::max(0, static_cast<int>(std::floor(minX)));
+        triangle.minY = std::max(0, static_cast<int>(std::floor(minY)));
+        triangle.maxX = std::min(width - 1, static_cast<int>(std::ceil(maxX)));
+        triangle.maxY = std::min(height - 1, static_cast<int>(std::ceil(maxY)));
+        if (triangle.minX > triangle.maxX || triangle.minY > triangle.maxY)
+            return;
+
+        unsigned int index = static_cast<unsigned int>(triangles.size());
+        triangles.push_back(triangle);
+        for (int ty = triangle.minY / TILE_SIZE; ty <= triangle.maxY / TILE_SIZE; ty++)
+        {
+            for (int tx = triangle.minX / TILE_SIZE; tx <= triangle.maxX / TILE_SIZE; tx++)
+                bins[ty * tilesX + tx].push_back(index);
+        }
+    }
+
+    void RenderTile(unsigned int tile)
+    {
+        const int tileX = static_cast<int>(tile % tilesX) * TILE_SIZE, tileY = static_cast<int>(tile / tilesX) * TILE_SIZE;
+        const int tileMaxX = std::min(width, tileX + TILE_SIZE) - 1, tileMaxY = std::min(height, tileY + TILE_SIZE) - 1;
+        alignas(16) float depth[TILE_SIZE * TILE_SIZE];
+        alignas(16) std::int32_t winner[TILE_SIZE * TILE_SIZE];
+        std::fill(depth, depth + TILE_SIZE * TILE_SIZE, 1.0f);
+        std::fill(winner, winner + TILE_SIZE * TILE_SIZE, -1);
+
+        for (unsigned int index : bins[tile])
+        {
+            const Triangle& t = triangles[index];
+            // whole groups of four, starting on a multiple of four inside the tile
+            const int x0 = tileX + ((std::max(t.minX, tileX) - tileX) & ~3);
+            const int x1 = std::min(t.maxX, tileMaxX);
+            const int y0 = std::max(t.minY, tileY), y1 = std::min(t.maxY, tileMaxY);
+            for (int y = y0; y <= y1; y++)
+            {
+                float* depthRow = depth + (y - tileY) * TILE_SIZE;
+                std::int32_t* winnerRow = winner + (y - tileY) * TILE_SIZE;
+                RasterizeSpan(t, static_cast<std::int32_t>(index), x0, x1, y, tileX, depthRow, winnerRow);
+            }
+        }
+
+        for (int y = tileY; y <= tileMaxY; y++)
+        {
+            for (int x = tileX; x <= tileMaxX; x++)
+            {
+                std::int32_t index = winner[(y - tileY) * TILE_SIZE + (x - tileX)];
+                glm::vec3 color = index < 0 ? clearColor : ShadePixel(triangles[index], x, y);
+                unsigned char* out = &pixels[(static_cast<std::size_t>(y) * width + x) * 3];
+                for (int c = 0; c < 3; c++)
+                    out[c] = static_cast<unsigned char>(glm::clamp(color[c], 0.0f, 1.0f) * 255.0f + 0.5f);
+            }
+        }
+    }
+
+    // pixels x0..x1 of row y, four at a time; x0 - tileX is a multiple of four
+    static void RasterizeSpan(const Triangle& t, std::int32_t index, int x0, int x1, int y, int tileX, float* depthRow, std::int32_t* winnerRow)
+    {
+        const float py = y + 0.5f;
+#ifdef SOFTWARE_RASTERIZER_SSE
+        __m128 e[3], step[3], bias[3];
+        const __m128 offsets = _mm_set_ps(3.5f, 2.5f, 1.5f, 0.5f);
+        for (int i = 0; i < 3; i++)
+        {
+            __m128 px = _mm_add_ps(_mm_set1_ps(static_cast<float>(x0)), offsets);
+            e[i] = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(t.edgeA[i]), px), _mm_set1_ps(t.edgeB[i] * py + t.edgeC[i]));
+            step[i] = _mm_set1_ps(t.edgeA[i] * 4.0f);
+            // e > 0 inside, e == 0 only on a top-left edge
+            bias[i] = _mm_castsi128_ps(_mm_set1_epi32(t.topLeft[i] ? -1 : 0));
+        }
+        const __m128 zero = _mm_setzero_ps();
+        const __m128 z0 = _mm_set1_ps(t.z[0] * t.invArea), z1 = _mm_set1_ps(t.z[1] * t.invArea), z2 = _mm_set1_ps(t.z[2] * t.invArea);
+        const __m128i id = _mm_set1_epi32(index);
+        for (int x = x0; x <= x1; x += 4)
+        {
+            __m128 inside = _mm_castsi128_ps(_mm_set1_epi32(-1));
+            for (int i = 0; i < 3; i++)
+                inside = _mm_and_ps(inside, _mm_or_ps(_mm_cmpgt_ps(e[i], zero), _mm_and_ps(_mm_cmpeq_ps(e[i], zero), bias[i])));
+            if (_mm_movemask_ps(inside))
+            {
+                // e[i] / area is the barycentric weight of vertex i
+                __m128 z = _mm_add_ps(_mm_add_ps(_mm_mul_ps(e[0], z0), _mm_mul_ps(e[1], z1)), _mm_mul_ps(e[2], z2));
+                float* d = depthRow + (x - tileX);
+                std::int32_t* w = winnerRow + (x - tileX);
+                __m128 old = _mm_load_ps(d);
+                __m128 pass = _mm_and_ps(inside, _mm_cmplt_ps(z, old));
+                _mm_store_ps(d, _mm_or_ps(_mm_and_ps(pass, z), _mm_andnot_ps(pass, old)));
+                __m128i oldId = _mm_load_si128(reinterpret_cast<const __m128i*>(w));
+                __m128i passId = _mm_castps_si128(pass);
+                _mm_store_si128(reinterpret_cast<__m128i*>(w), _mm_or_si128(_mm_and_si128(passId, id), _mm_andnot_si128(passId, oldId)));
+            }
+            for (int i = 0; i < 3; i++)
+                e[i] = _mm_add_ps(e[i], step[i]);
+        }
+#else
+        for (int x = x0; x <= x1; x++)
+        {
+            const float px = x + 0.5f;
+            float e[3];
+            bool inside = true;
+            for (int i = 0; i < 3; i++)
+            {
+                e[i] = t.edgeA[i] * px + t.edgeB[i] * py + t.edgeC[i];
+                inside = inside && (e[i] > 0.0f || (e[i] == 0.0f && t.topLeft[i]));
+            }
+            float z = (e[0] * t.z[0] + e[1] * t.z[1] + e[2] * t.z[2]) * t.invArea;
+            if (inside && z < depthRow[x - tileX])
+            {
+                depthRow[x - tileX] = z;
+                winnerRow[x - tileX] = index;
+            }
+        }
+#endif
+    }
+
+    // perspective-correct weights of the three vertices at a pixel center
+    static glm::vec3 Weights(const Triangle& t, float px, float py)
+    {
+        glm::vec3 w;
+        for (int i = 0; i < 3; i++)
+            w[i] = (t.edgeA[i] * px + t.edgeB[i] * py + t.edgeC[i]) * t.invW[i];
+        return w / (w.x + w.y + w.z);
+    }
+
+    static glm::vec2 InterpolateUv(const Triangle& t, const glm::vec3& w)
+    {
+        return t.vertex[0].uv * w.x + t.vertex[1].uv * w.y + t.vertex[2].uv * w.z;
+    }
+
+    glm::vec3 ShadePixel(const Triangle& t, int x, int y) const
+    {
+        const SoftwareDraw& draw = (*draws)[t.draw];
+        if (!draw.lit)
+            return draw.color;
+        const float px = x + 0.5f, py = y + 0.5f;
+        glm::vec3 w = Weights(t, px, py);
+        SpecularSample sample;
+        sample.fragPos = t.vertex[0].world * w.x + t.vertex[1].world * w.y + t.vertex[2].world * w.z;
+        sample.normal = t.vertex[0].normal * w.x + t.vertex[1].normal * w.y + t.vertex[2].normal * w.z;
+        glm::vec2 uv = InterpolateUv(t, w);
+        // texture coordinate derivatives from the neighbouring pixels, for the mip level
+        glm::vec2 dx = InterpolateUv(t, Weights(t, px + 1.0f, py)) - uv;
+        glm::vec2 dy = InterpolateUv(t, Weights(t, px, py + 1.0f)) - uv;
+        sample.diffuse = Fetch(draw.diffuse, uv, dx, dy);
+        sample.specular = Fetch(draw.specular, uv, dx, dy);
+        return ShadeSpecular(*lighting, sample, viewPos, viewFront) * lightTint;
+    }
+
+    static glm::vec3 Fetch(const SoftwareTexture* texture, const glm::vec2& uv, const glm::vec2& dx, const glm::vec2& dy)
+    {
+        if (!texture)
+            return glm::vec3(0.0f);
+        glm::vec2 size(static_cast<float>(texture->Width()), static_cast<float>(texture->Height()));
+        float rho = std::max(glm::length(dx * size), glm::length(dy * size));
+        // NaN from a degenerate neighbour fails the test and takes the base level
+        return texture->Sample(uv, rho > 1.0f ? std::log2(rho) : 0.0f);
+    }
+
+    int width, height;
+    int tilesX, tilesY;
+    std::vector<unsigned char> pixels;
+    std::vector<Vertex> vertices;
+    std::vector<Triangle> triangles;
+    std::vector<std::vector<unsigned int>> bins;
+
+    // the frame being rendered
+    const std::vector<SoftwareDraw>* draws = NULL;
+    const SpecularLighting* lighting = NULL;
+    glm::vec3 viewPos, viewFront, lightTint, clearColor;
+};
+#endif
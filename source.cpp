@@ -1,4 +1,5 @@
 #include <glad/glad.h>
+#include "gl_counters.h"
 #include <GLFW/glfw3.h>
 #include "stb_image.h"
 #include <glm/glm.hpp>
@@ -9,30 +10,137 @@
 #include "camera.h"
 #include "model.h"
 #include <iostream>
+#include <string>
+#include <vector>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <chrono>
+#include <map>
+#include <memory>
 #include "pen_accent.h"
 #include "pen_body.h"
 #include "pen_clip.h"
 #include "pen_point.h"
+#include "transform_system.h"
+#include "program_cache.h"
+#include "shader_permutations.h"
+#include "job_system.h"
+#include "render_list.h"
+#include "uniform_ring.h"
+#include "startup_profile.h"
+#include "frame_pacer.h"
+#include "dynamic_resolution.h"
+#include "occlusion_culling.h"
+#include "portal_visibility.h"
+#include "bvh.h"
+#include "lod.h"
+#include "binary_model.h"
+#include "stress_scene.h"
+#include "stress_benchmark.h"
+#include "specular_lighting.h"
+#include "software_rasterizer.h"
+#include "image_file.h"
+#include "regression_suite.h"
+#include "frame_profiler.h"
+#include "gpu_memory.h"
+#include "gl_handles.h"
+#include "frame_arena.h"
+#include "texture_streaming.h"
+#include <new>
+
+// every operator new is counted, so the render loop can check that a frame in steady
+// state allocates nothing from the heap
+void* operator new(std::size_t size)
+{
+    HeapAllocations().fetch_add(1, std::memory_order_relaxed);
+    if (void* memory = std::malloc(size ? size : 1))
+        return memory;
+    throw std::bad_alloc();
+}
+void* operator new[](std::size_t size)
+{
+    return operator new(size);
+}
+void operator delete(void* memory) noexcept
+{
+    std::free(memory);
+}
+void operator delete[](void* memory) noexcept
+{
+    std::free(memory);
+}
+void operator delete(void* memory, std::size_t) noexcept
+{
+    std::free(memory);
+}
+void operator delete[](void* memory, std::size_t) noexcept
+{
+    std::free(memory);
+}
 
 void framebuffer_size_callback(GLFWwindow* window, int width, int height);
 void mouse_callback(GLFWwindow* window, double xpos, double ypos);
 void scroll_callback(GLFWwindow* window, double xoffset, double yoffset);
+void refresh_callback(GLFWwindow* window);
+void mouse_button_callback(GLFWwindow* window, int button, int action, int mods);
+void key_callback(GLFWwindow* window, int key, int scancode, int action, int mods);
 void processInput(GLFWwindow* window);
 unsigned int loadTexture(const char* path);
+struct DecodedTexture;
+DecodedTexture decodeTexture(const char* path, bool streamed = false);
+GlTexture uploadTexture(DecodedTexture& texture, TextureStreamer* streamer = NULL);
+bool decodeMips(const char* path, MipChain& mips);
 void GetDesktopResolution(float& horizontal, float& vertical);
 // settings
 
 float SCR_WIDTH = 800;
 float SCR_HEIGHT = 600;
-bool redLight = false;
-bool blueLight = false;
-bool purpleLight = false;
-bool noLight = true;
+// light color mode, picked with keys 0-3: 0 = white, 1 = red, 2 = blue, 3 = purple
+int lightMode = 0;
+// white light configuration (--white), as source white lights.cpp had it: every light cube
+// is drawn with green.fs, key 1 gives the red and blue light and there is no key 3
+bool whiteLights = false;
+// on-demand rendering (--on-demand): a still scene is not redrawn until something changes
+bool onDemand = false;
+bool sceneDirty = true;
+// frame rate cap (--fps N); 0 leaves the loop unpaced
+double targetFps = 0.0;
+// GPU time budget for the scene (--gpu-budget MS); when set, the render resolution adapts to it
+float gpuBudgetMs = 0.0f;
+// objects hidden last frame are skipped on the GPU (--no-occlusion turns this off)
+bool occlusionCulling = true;
+// only rooms seen through doors and windows are drawn (--no-portals turns this off)
+bool portalCulling = true;
+// an extra asset in the .mesh format (--model file.mesh), made with tools/mesh_convert
+const char* modelPath = NULL;
+// generated building for scaling tests (--stress ROWS COLUMNS LIGHTS)
+StressSceneConfig stressConfig;
+// record this many frames, append the results to benchmarkCsv and exit (--benchmark FRAMES)
+unsigned int benchmarkFrames = 0;
+std::string benchmarkCsv = "benchmark.csv";
+// render the first frame on the CPU, write it to this .tga and exit (--reference PATH)
+const char* referencePath = NULL;
+int referenceWidth = 1280, referenceHeight = 720;
+// render fixed poses in every light mode offscreen, compare with the goldens and timing
+// baseline in this directory and exit (--regression DIR); --regression-update DIR rewrites them
+const char* regressionPath = NULL;
+bool regressionUpdate = false;
 // camera
 Camera camera(glm::vec3(0.0f, 0.0f, 3.0f));
 float lastX = SCR_WIDTH / 2.0f;
 float lastY = SCR_HEIGHT / 2.0f;
 bool firstMouse = true;
+// a left click picks the object under the crosshair, on the next frame
+bool pickRequested = false;
+// P writes the profile of the last traceFrames frames as Chrome trace JSON (--trace-frames N)
+bool traceRequested = false;
+unsigned int traceFrames = 120;
+// M prints what the GPU objects take up; going over the budget warns (--vram-budget MB)
+bool memoryReportRequested = false;
+float vramBudgetMb = 0.0f;
+// the scene's textures keep only the mips they are seen at, within this many MB (--texture-budget MB)
+float textureBudgetMb = 128.0f;
 
 // timing
 float deltaTime = 0.0f;
@@ -41,8 +149,137 @@ float lastFrame = 0.0f;
 // lighting
 glm::vec3 lightPos(1.2f, 1.0f, 2.0f);
 
-int main()
+// per-mode light color waveform, evaluated in specular.fs as bias + amplitude * (sin(frequency * time + phase) / 2 + 0.5)
+struct LightWave
+{
+    glm::vec3 amplitude;
+    glm::vec3 bias;
+    float frequency;
+    float phase;
+};
+const LightWave lightWaves[] = {
+    { glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(1.0f, 1.0f, 1.0f), 1.0f, 0.0f },  // white
+    { glm::vec3(1.0f, 0.0f, 0.0f), glm::vec3(0.0f, 0.0f, 0.0f), 1.0f, 0.0f },  // red
+    { glm::vec3(0.0f, 0.0f, 1.0f), glm::vec3(0.0f, 0.0f, 0.0f), 1.0f, 0.0f },  // blue
+    { glm::vec3(1.0f, 0.0f, 1.0f), glm::vec3(0.0f, 0.0f, 0.0f), 1.0f, 0.0f },  // purple
+};
+
+// CalcLightColor in specular.fs
+glm::vec3 lightTint(int mode, float time)
+{
+    const LightWave& wave = lightWaves[mode];
+    return wave.bias + wave.amplitude * (glm::sin(wave.frequency * time + wave.phase) / 2.0f + 0.5f);
+}
+
+// an image decoded by stb_image, waiting for the GL thread to upload it
+struct DecodedTexture
+{
+    const char* path;
+    unsigned char* data;
+    int width;
+    int height;
+    int nrComponents;
+    MipChain mips;      // for streamed textures only
+};
+
+int main(int argc, char** argv)
 {
+    StartupProfile startup;
+    Profiler().ThreadRing("GL thread");
+    for (int i = 1; i < argc; i++)
+    {
+        if (std::string(argv[i]) == "--white")
+            whiteLights = true;
+        if (std::string(argv[i]) == "--on-demand")
+            onDemand = true;
+        if (std::string(argv[i]) == "--fps" && i + 1 < argc)
+            targetFps = std::atof(argv[++i]);
+        if (std::string(argv[i]) == "--gpu-budget" && i + 1 < argc)
+            gpuBudgetMs = static_cast<float>(std::atof(argv[++i]));
+        if (std::string(argv[i]) == "--no-occlusion")
+            occlusionCulling = false;
+        if (std::string(argv[i]) == "--no-portals")
+            portalCulling = false;
+        if (std::string(argv[i]) == "--model" && i + 1 < argc)
+            modelPath = argv[++i];
+        if (std::string(argv[i]) == "--stress" && i + 3 < argc)
+        {
+            stressConfig.rows = static_cast<unsigned int>(std::atoi(argv[++i]));
+            stressConfig.columns = static_cast<unsigned int>(std::atoi(argv[++i]));
+            stressConfig.lights = static_cast<unsigned int>(std::atoi(argv[++i]));
+        }
+        if (std::string(argv[i]) == "--benchmark" && i + 1 < argc)
+            benchmarkFrames = static_cast<unsigned int>(std::atoi(argv[++i]));
+        if (std::string(argv[i]) == "--benchmark-csv" && i + 1 < argc)
+            benchmarkCsv = argv[++i];
+        if (std::string(argv[i]) == "--reference" && i + 1 < argc)
+            referencePath = argv[++i];
+        if (std::string(argv[i]) == "--reference-size" && i + 2 < argc)
+        {
+            referenceWidth = std::max(1, std::atoi(argv[++i]));
+            referenceHeight = std::max(1, std::atoi(argv[++i]));
+        }
+        if (std::string(argv[i]) == "--vram-budget" && i + 1 < argc)
+            vramBudgetMb = static_cast<float>(std::atof(argv[++i]));
+        if (std::string(argv[i]) == "--texture-budget" && i + 1 < argc)
+            textureBudgetMb = static_cast<float>(std::max(0.0, std::atof(argv[++i])));
+        if (std::string(argv[i]) == "--trace-frames" && i + 1 < argc)
+            traceFrames = static_cast<unsigned int>(std::max(1, std::atoi(argv[++i])));
+        if (std::string(argv[i]) == "--regression" && i + 1 < argc)
+            regressionPath = argv[++i];
+        if (std::string(argv[i]) == "--regression-update" && i + 1 < argc)
+        {
+            regressionPath = argv[++i];
+            regressionUpdate = true;
+        }
+    }
+    if (stressConfig.lights > StressSceneConfig::MAX_LIGHTS)
+    {
+        std::cout << "--stress: at most " << StressSceneConfig::MAX_LIGHTS << " extra lights" << std::endl;
+        stressConfig.lights = StressSceneConfig::MAX_LIGHTS;
+    }
+    // a benchmark measures every frame at full speed
+    if (benchmarkFrames > 0)
+        onDemand = false;
+    GpuMemory().SetBudget(static_cast<std::size_t>(vramBudgetMb * 1024.0f * 1024.0f));
+    StressLayout stressLayout(stressConfig);
+    std::vector<glm::vec3> stressLights = stressLayout.LightPositions();
+
+    // per-frame CPU work runs as a task graph on the worker threads; the GL thread
+    // only fills in the camera and replays the finished command lists. At startup the
+    // same workers decode the textures while the window opens and the shaders compile.
+    JobSystem jobs;
+    const char* texturePaths[] = {
+        "resources/textures/class/red.jpg",
+        "resources/textures/class/blue.jpg",
+        "resources/textures/class/lightgrey.jpg",
+        "resources/textures/class/protractor2.jpg",
+        "resources/textures/class/wall.jpg",
+        "resources/textures/class/blackboard.jpg",
+        "resources/textures/class/AdobeStock_321846439.png",
+        "resources/textures/class/grey.jpg",
+        "resources/textures/class/purple.jpg",
+        "resources/textures/class/damkier.png",
+        "resources/textures/class/AdobeStock_372442505.png",
+        "resources/textures/class/AdobeStock_372442505.png",
+    };
+    const unsigned int TEXTURE_COUNT = sizeof(texturePaths) / sizeof(texturePaths[0]);
+    DecodedTexture decodedTextures[TEXTURE_COUNT];
+    std::atomic<int> texturesDecoding(static_cast<int>(TEXTURE_COUNT));
+    for (unsigned int i = 0; i < TEXTURE_COUNT; i++)
+    {
+        jobs.Submit([&decodedTextures, &texturePaths, &texturesDecoding, i]() {
+            decodedTextures[i] = decodeTexture(texturePaths[i], true);
+            texturesDecoding--;
+        });
+    }
+    // the early exits below wait for the decode jobs, whose targets are about to go out of scope
+    auto discardTextures = [&]() {
+        jobs.Wait(texturesDecoding);
+        for (DecodedTexture& texture : decodedTextures)
+            stbi_image_free(texture.data);
+    };
+
     GetDesktopResolution(SCR_WIDTH, SCR_HEIGHT);
     glfwInit();
     glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
@@ -57,6 +294,7 @@ int main()
     if (window == NULL)
     {
         std::cout << "Failed to create GLFW window" << std::endl;
+        discardTextures();
         glfwTerminate();
         return -1;
     }
@@ -64,21 +302,48 @@ int main()
     glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
     glfwSetCursorPosCallback(window, mouse_callback);
     glfwSetScrollCallback(window, scroll_callback);
+    glfwSetWindowRefreshCallback(window, refresh_callback);
+    glfwSetMouseButtonCallback(window, mouse_button_callback);
+    glfwSetKeyCallback(window, key_callback);
     glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
 
     if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress))
     {
         std::cout << "Failed to initialize GLAD" << std::endl;
+        discardTextures();
+        glfwTerminate();
         return -1;
     }
 
-    glEnable(GL_DEPTH_TEST);
-    Shader lightingShader("specular.vs", "specular.fs");
-    Shader greenShader("glsl.vs", "green.fs");
-    Shader pinkShader("glsl.vs", "pink.fs");
-    Shader purpleShader("glsl.vs", "purple.fs");
+    startup.Mark("window");
 
-    float lightvertices[] = {
+    glEnable(GL_DEPTH_TEST);
+#ifdef GL_KHR_parallel_shader_compile
+    // let the driver compile on its own threads; nothing waits on a program until Finish()
+    if (GLAD_GL_KHR_parallel_shader_compile)
+        glMaxShaderCompilerThreadsKHR(0xFFFFFFFF);
+#endif
+    // programs linked on an earlier run come back from the binary cache without compiling
+    ProgramCache programCache;
+    // each lighting variant is compiled once here; the loop only picks between them
+    ShaderPermutations lightingPermutations("specular.vs", "specular.fs", &programCache);
+    const int shadedLights = 4 + static_cast<int>(stressLights.size());
+    LightingPermutation whitePermutation = { shadedLights, 0, false };
+    LightingPermutation colorPermutation = { shadedLights, 1, false };
+    ShaderProgram& whiteLightingShader = lightingPermutations.Get(whitePermutation);
+    ShaderProgram& colorLightingShader = lightingPermutations.Get(colorPermutation);
+    ShaderPermutations greenPrograms("glsl.vs", "green.fs", &programCache);
+    ShaderPermutations pinkPrograms("glsl.vs", "pink.fs", &programCache);
+    ShaderPermutations purplePrograms("glsl.vs", "purple.fs", &programCache);
+    ShaderPermutations whitePrograms("glsl.vs", "white.fs", &programCache);
+    ShaderProgram& greenShader = greenPrograms.Get();
+    ShaderProgram& pinkShader = pinkPrograms.Get();
+    ShaderProgram& purpleShader = purplePrograms.Get();
+    ShaderProgram& whiteShader = whitePrograms.Get();
+    startup.Mark("shader submit");
+
+    // mesh data is static and read-only: it lives in the binary and is uploaded as it is
+    static constexpr float lightvertices[] = {
         // positions         
         -0.5f, -0.5f, -0.5f,
          0.5f, -0.5f, -0.5f,
@@ -123,7 +388,7 @@ int main()
         -0.5f,  0.5f, -0.5f,
     };
 
-    float vertices[] = {
+    static constexpr float vertices[] = {
         // positions          // normals           // texture coords
         -0.5f, -0.5f, -0.5f,  0.0f,  0.0f, -1.0f,  0.0f,  0.0f,
          0.5f, -0.5f, -0.5f,  0.0f,  0.0f, -1.0f,  1.0f,  0.0f,   // this is a modufied cube z axis is my x axis and it is modified to be less tall
@@ -168,7 +433,7 @@ int main()
         -0.5f,  0.5f, -0.5f,  0.0f,  1.0f,  0.0f,  0.0f,  1.0f
     };
 
-    float groundVertices[] = {
+    static constexpr float groundVertices[] = {
         // positions          // normals           // texture coords
 
         -0.5f,  0.5f, -0.5f,  0.0f,  1.0f,  0.0f,  0.0f,  1.0f,
@@ -179,7 +444,7 @@ int main()
         -0.5f,  0.5f, -0.5f,  0.0f,  1.0f,  0.0f,  0.0f,  1.0f
     };
 
-    float blackboard[] = {
+    static constexpr float blackboard[] = {
         // positions          // normals           // texture coords
         -0.5f, -0.5f, -0.01f,  0.0f,  0.0f, -1.0f,  0.0f,  0.0f,
          0.5f, -0.5f, -0.01f,  0.0f,  0.0f, -1.0f,  1.0f,  0.0f,
@@ -225,7 +490,7 @@ int main()
     };
 
 
-    float compassVertices[] = {
+    static constexpr float compassVertices[] = {
          0.49f, -0.5f, .5f,    0.0f,  0.0f, -1.0f,     0.0f, 0.0f, // back rectangle
          0.5f, -0.5f, .5f,     0.0f, -1.0f,  0.0f,   0.0f, 1.0f,
          0.49f, 0.5f, .5f,     0.0f,  0.0f, -1.0f,   1.0f, 0.0f,
@@ -291,24 +556,76 @@ int main()
 
     };
 
-    unsigned int redTexture = loadTexture("resources/textures/class/red.jpg");
-    unsigned int blueTexture = loadTexture("resources/textures/class/blue.jpg");
-    unsigned int lightgreyTexture = loadTexture("resources/textures/class/lightgrey.jpg");
-    unsigned int compassTexture = loadTexture("resources/textures/class/protractor2.jpg");
-    unsigned int skyboxTexture = loadTexture("resources/textures/class/wall.jpg");
-    unsigned int blackboardTexture = loadTexture("resources/textures/class/blackboard.jpg");
-    unsigned int groundTexture = loadTexture("resources/textures/class/AdobeStock_321846439.png");
-    unsigned int greyTexture = loadTexture("resources/textures/class/grey.jpg");
-    unsigned int purpleTexture = loadTexture("resources/textures/class/purple.jpg");
-    unsigned int metalTexture = loadTexture("resources/textures/class/damkier.png");
-    unsigned int deskTexture = loadTexture("resources/textures/class/AdobeStock_372442505.png");
-    unsigned int ballpointTexture = loadTexture("resources/textures/class/AdobeStock_372442505.png");
-
-    unsigned int blackboardVBO, blackboardVAO;
-    glGenVertexArrays(1, &blackboardVAO);
-    glGenBuffers(1, &blackboardVBO);
+    jobs.Wait(texturesDecoding);
+    // CPU copies for the reference renderer, taken before the upload frees the pixels
+    std::vector<std::unique_ptr<SoftwareTexture>> softwareTextures(TEXTURE_COUNT);
+    for (unsigned int i = 0; i < TEXTURE_COUNT && referencePath; i++)
+    {
+        const DecodedTexture& decoded = decodedTextures[i];
+        if (decoded.data)
+            softwareTextures[i].reset(new SoftwareTexture(decoded.data, decoded.width, decoded.height, decoded.nrComponents));
+    }
+    // only the coarse mips go up now; the frames ask for the rest as objects come close
+    TextureStreamer textureStreamer(jobs, decodeMips, static_cast<std::size_t>(textureBudgetMb * 1024.0f * 1024.0f));
+    GlTexture redTexture = uploadTexture(decodedTextures[0], &textureStreamer);
+    GlTexture blueTexture = uploadTexture(decodedTextures[1], &textureStreamer);
+    GlTexture lightgreyTexture = uploadTexture(decodedTextures[2], &textureStreamer);
+    GlTexture compassTexture = uploadTexture(decodedTextures[3], &textureStreamer);
+    GlTexture skyboxTexture = uploadTexture(decodedTextures[4], &textureStreamer);
+    GlTexture blackboardTexture = uploadTexture(decodedTextures[5], &textureStreamer);
+    GlTexture groundTexture = uploadTexture(decodedTextures[6], &textureStreamer);
+    GlTexture greyTexture = uploadTexture(decodedTextures[7], &textureStreamer);
+    GlTexture purpleTexture = uploadTexture(decodedTextures[8], &textureStreamer);
+    GlTexture metalTexture = uploadTexture(decodedTextures[9], &textureStreamer);
+    GlTexture deskTexture = uploadTexture(decodedTextures[10], &textureStreamer);
+    GlTexture ballpointTexture = uploadTexture(decodedTextures[11], &textureStreamer);
+    // a regression frame must not depend on how far streaming has got
+    if (regressionPath)
+    {
+        textureStreamer.SetUploadLimit(0);
+        textureStreamer.SetBlocking(true);
+    }
+    startup.Mark("textures");
+
+    // static object transforms: built once by the first UpdateWorld() and then left alone
+    // (the old code rotated before translating, so those offsets are pre-rotated here)
+    TransformSystem transforms;
+    glm::quat compassRotation = glm::angleAxis(glm::radians(240.0f), glm::normalize(glm::vec3(0.01f, 0.01f, 0.01f)));
+    TransformSystem::Handle compassTransform = transforms.Add(compassRotation * glm::vec3(0.14f, -0.2f, .467f), compassRotation, glm::vec3(1.1f) * glm::vec3(.75f, .75f, .25f));
+    TransformSystem::Handle blackboardTransform = transforms.Add(glm::vec3(0.0f, 1.5f, -3.67f), glm::quat(1.0f, 0.0f, 0.0f, 0.0f), glm::vec3(4.0f));
+
+    glm::quat lidRotation = glm::angleAxis(glm::radians(7.0f), glm::vec3(0.0f, -1.0f, 0.0f));
+    glm::quat bookRotation = glm::angleAxis(glm::radians(-9.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+    TransformSystem::Handle deskTransforms[10];
+    deskTransforms[1] = transforms.Add(glm::vec3(0.0f, 0.0f, 0.0f), glm::quat(1.0f, 0.0f, 0.0f, 0.0f), glm::vec3(1.8f, 1.2f, 1.5f));
+    deskTransforms[2] = transforms.Add(glm::vec3(0.0f, .62f, 0.05f), glm::quat(1.0f, 0.0f, 0.0f, 0.0f), glm::vec3(.4f, .035f, .6f));
+    deskTransforms[3] = transforms.Add(glm::vec3(0.0f, .695f, 0.03f), glm::quat(1.0f, 0.0f, 0.0f, 0.0f), glm::vec3(.4f, .035f, .4f));
+    deskTransforms[4] = transforms.Add(glm::vec3(-.5f, .64f, 0.0285f), glm::quat(1.0f, 0.0f, 0.0f, 0.0f), glm::vec3(.4f, .07f, .5f));
+    deskTransforms[5] = transforms.Add(glm::vec3(-.5f, .605f, 0.03f), glm::quat(1.0f, 0.0f, 0.0f, 0.0f), glm::vec3(.41f, .01f, .51f));
+    deskTransforms[6] = transforms.Add(glm::vec3(-.50f, .678f, 0.03f), glm::quat(1.0f, 0.0f, 0.0f, 0.0f), glm::vec3(.41f, .01f, .51f));
+    deskTransforms[7] = transforms.Add(glm::vec3(-.3f, .639f, 0.03f), glm::quat(1.0f, 0.0f, 0.0f, 0.0f), glm::vec3(.01f, .07f, .51f));
+    deskTransforms[8] = transforms.Add(lidRotation * glm::vec3(-.50f, .7f, 0.05f), lidRotation, glm::vec3(.31f, .03f, .41f));
+    deskTransforms[9] = transforms.Add(bookRotation * glm::vec3(0.0f, .66f, 0.03f), bookRotation, glm::vec3(.4f, .035f, .6f));
+
+    // the ground has always been placed relative to the blackboard's matrix
+    TransformSystem::Handle groundTransform = transforms.Add(glm::vec3(0.0f, -4.1f, -0.3f), glm::quat(1.0f, 0.0f, 0.0f, 0.0f), glm::vec3(7.0f), blackboardTransform);
+    const glm::vec3 wallCubeCenter(0.0f, 0.0f, -0.2f);
+    const float wallCubeSize = 7.0f;
+    TransformSystem::Handle skyboxTransform = transforms.Add(wallCubeCenter, glm::quat(1.0f, 0.0f, 0.0f, 0.0f), glm::vec3(wallCubeSize));
+    // the rooms for portal visibility, bounded by the wall cube; cell 0 is the classroom
+    PortalVisibility rooms;
+    stressLayout.AddCells(rooms, wallCubeCenter, wallCubeSize);
+    TransformSystem::Handle lightCubeTransforms[6];
+    for (unsigned int i = 0; i < 6; i++)
+        lightCubeTransforms[i] = transforms.Add(pointLightPositions[i], glm::quat(1.0f, 0.0f, 0.0f, 0.0f), glm::vec3(0.4f));
+    const glm::mat4 penModel = glm::mat4(0.5f);
+
+    GlBuffer blackboardVBO(GlPools().buffers);
+    GlVertexArray blackboardVAO(GlPools().vertexArrays);
     glBindBuffer(GL_ARRAY_BUFFER, blackboardVBO);
     glBufferData(GL_ARRAY_BUFFER, sizeof(blackboard), blackboard, GL_STATIC_DRAW);
+    GpuMemory().Allocate(GpuResource::Buffer, blackboardVBO, sizeof(blackboard), "GL_ARRAY_BUFFER static", "classroom meshes");
+    GpuMemory().Allocate(GpuResource::VertexArray, blackboardVAO, 0, "3 attributes", "classroom meshes");
     glBindVertexArray(blackboardVAO);
     glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)0);
     glEnableVertexAttribArray(0);
@@ -317,11 +634,12 @@ int main()
     glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(6 * sizeof(float)));
     glEnableVertexAttribArray(2);
 
-    unsigned int compassVBO, compassVAO;
-    glGenVertexArrays(1, &compassVAO);
-    glGenBuffers(1, &compassVBO);
+    GlBuffer compassVBO(GlPools().buffers);
+    GlVertexArray compassVAO(GlPools().vertexArrays);
     glBindBuffer(GL_ARRAY_BUFFER, compassVBO);
     glBufferData(GL_ARRAY_BUFFER, sizeof(compassVertices), compassVertices, GL_STATIC_DRAW);
+    GpuMemory().Allocate(GpuResource::Buffer, compassVBO, sizeof(compassVertices), "GL_ARRAY_BUFFER static", "classroom meshes");
+    GpuMemory().Allocate(GpuResource::VertexArray, compassVAO, 0, "3 attributes", "classroom meshes");
     glBindVertexArray(compassVAO);
     glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)0);
     glEnableVertexAttribArray(0);
@@ -330,11 +648,12 @@ int main()
     glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(6 * sizeof(float)));
     glEnableVertexAttribArray(2);
 
-    unsigned int bookVBO, bookVAO;
-    glGenVertexArrays(1, &bookVAO);
-    glGenBuffers(1, &bookVBO);
+    GlBuffer bookVBO(GlPools().buffers);
+    GlVertexArray bookVAO(GlPools().vertexArrays);
     glBindBuffer(GL_ARRAY_BUFFER, bookVBO);
     glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
+    GpuMemory().Allocate(GpuResource::Buffer, bookVBO, sizeof(vertices), "GL_ARRAY_BUFFER static", "classroom meshes");
+    GpuMemory().Allocate(GpuResource::VertexArray, bookVAO, 0, "3 attributes", "classroom meshes");
     glBindVertexArray(bookVAO);
     glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)0);
     glEnableVertexAttribArray(0);
@@ -343,11 +662,10 @@ int main()
     glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(6 * sizeof(float)));
     glEnableVertexAttribArray(2);
 
-    unsigned int skyboxVBO, skyboxVAO;
-    glGenVertexArrays(1, &skyboxVAO);
-    glGenBuffers(1, &skyboxVBO);
-    glBindBuffer(GL_ARRAY_BUFFER, skyboxVBO);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
+    // the wall cube is the same mesh as the desk, so it reads from the desk's buffer
+    GlVertexArray skyboxVAO(GlPools().vertexArrays);
+    GpuMemory().Allocate(GpuResource::VertexArray, skyboxVAO, 0, "3 attributes, desk buffer", "classroom meshes");
+    glBindBuffer(GL_ARRAY_BUFFER, bookVBO);
     glBindVertexArray(skyboxVAO);
     glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)0);
     glEnableVertexAttribArray(0);
@@ -356,11 +674,12 @@ int main()
     glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(6 * sizeof(float)));
     glEnableVertexAttribArray(2);
 
-    unsigned int groundVBO, groundVAO;
-    glGenVertexArrays(1, &groundVAO);
-    glGenBuffers(1, &groundVBO);
+    GlBuffer groundVBO(GlPools().buffers);
+    GlVertexArray groundVAO(GlPools().vertexArrays);
     glBindBuffer(GL_ARRAY_BUFFER, groundVBO);
     glBufferData(GL_ARRAY_BUFFER, sizeof(groundVertices), groundVertices, GL_STATIC_DRAW);
+    GpuMemory().Allocate(GpuResource::Buffer, groundVBO, sizeof(groundVertices), "GL_ARRAY_BUFFER static", "classroom meshes");
+    GpuMemory().Allocate(GpuResource::VertexArray, groundVAO, 0, "3 attributes", "classroom meshes");
     glBindVertexArray(groundVAO);
     glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)0);
     glEnableVertexAttribArray(0);
@@ -370,450 +689,639 @@ int main()
     glEnableVertexAttribArray(2);
     // light boxes
 
-    unsigned int cubeVAO, cubeVBO;
-    glGenVertexArrays(1, &cubeVAO);
-    glGenBuffers(1, &cubeVBO);
+    GlVertexArray cubeVAO(GlPools().vertexArrays);
+    GlBuffer cubeVBO(GlPools().buffers);
     glBindVertexArray(cubeVAO);
     glBindBuffer(GL_ARRAY_BUFFER, cubeVBO);
     glBufferData(GL_ARRAY_BUFFER, sizeof(lightvertices), &lightvertices, GL_STATIC_DRAW);
+    GpuMemory().Allocate(GpuResource::Buffer, cubeVBO, sizeof(lightvertices), "GL_ARRAY_BUFFER static", "light cubes");
+    GpuMemory().Allocate(GpuResource::VertexArray, cubeVAO, 0, "1 attribute", "light cubes");
     glEnableVertexAttribArray(0);
     glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
-    unsigned int uniformBlockIndexPink = glGetUniformBlockIndex(pinkShader.ID, "Matrices");
-    unsigned int uniformBlockIndexGreen = glGetUniformBlockIndex(greenShader.ID, "Matrices");
-    unsigned int uniformBlockIndexPurple = glGetUniformBlockIndex(purpleShader.ID, "Matrices");
-    glUniformBlockBinding(pinkShader.ID, uniformBlockIndexPink, 0);
-    glUniformBlockBinding(greenShader.ID, uniformBlockIndexGreen, 0);
-    glUniformBlockBinding(greenShader.ID, uniformBlockIndexPurple, 0);
-    unsigned int uboMatrices;
-    glGenBuffers(1, &uboMatrices);
-    glBindBuffer(GL_UNIFORM_BUFFER, uboMatrices);
-    glBufferData(GL_UNIFORM_BUFFER, 2 * sizeof(glm::mat4), NULL, GL_STATIC_DRAW);
-    glBindBuffer(GL_UNIFORM_BUFFER, 0);
-    glBindBufferRange(GL_UNIFORM_BUFFER, 0, uboMatrices, 0, 2 * sizeof(glm::mat4));
-    glm::mat4 projection = glm::perspective(95.0f, (float)SCR_WIDTH / (float)SCR_HEIGHT, 0.1f, 100.0f);
-    glBindBuffer(GL_UNIFORM_BUFFER, uboMatrices);
-    glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(glm::mat4), glm::value_ptr(projection));
-    glBindBuffer(GL_UNIFORM_BUFFER, 0);
-
-
-    lightingShader.use();
-    lightingShader.setInt("material.diffuse", 0);
-    lightingShader.setInt("material.specular", 1);
 
-    while (!glfwWindowShouldClose(window))
-    {
-        float currentFrame = static_cast<float>(glfwGetTime());
-        deltaTime = currentFrame - lastFrame;
-        lastFrame = currentFrame;
+    // pens are built once; they used to be regenerated every frame
+    std::unique_ptr<PenBody> penBody(new PenBody());
+    std::unique_ptr<PenClip> penClip(new PenClip());
+    std::unique_ptr<PenAccent> sphereAccent(new PenAccent());
+    std::unique_ptr<PenPoint> penPoint(new PenPoint());
 
-        processInput(window);
+    startup.Mark("geometry");
 
-        glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
-        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+    // the first query of each program's status, by which time most have finished linking
+    {
+        ProfileScope scope("link programs");
+        lightingPermutations.Finish();
+        greenPrograms.Finish();
+        pinkPrograms.Finish();
+        purplePrograms.Finish();
+        whitePrograms.Finish();
+    }
+    if (programCache.Supported())
+        std::cout << "Program cache: " << programCache.Hits() << " loaded, " << programCache.Misses() << " compiled" << std::endl;
+    startup.Mark("shader link");
 
-        lightingShader.use();
-        lightingShader.setVec3("viewPos", camera.Position);
-        lightingShader.setFloat("material.shininess", 32.0f);
+    // every shader reads projection/view and its model matrix from the uniform ring
+    unsigned int ringPrograms[] = { whiteLightingShader.ID, colorLightingShader.ID, greenShader.ID, pinkShader.ID, purpleShader.ID, whiteShader.ID };
+    for (unsigned int program : ringPrograms)
+    {
+        glUniformBlockBinding(program, glGetUniformBlockIndex(program, "Matrices"), MATRICES_BINDING);
+        glUniformBlockBinding(program, glGetUniformBlockIndex(program, "Object"), OBJECT_BINDING);
+    }
 
-        lightingShader.use();
-        lightingShader.setVec3("viewPos", camera.Position);
-        lightingShader.setFloat("material.shininess", 32.0f);
 
+    whiteLightingShader.use();
+    whiteLightingShader.setInt("material.diffuse", 0);
+    whiteLightingShader.setInt("material.specular", 1);
+    colorLightingShader.use();
+    colorLightingShader.setInt("material.diffuse", 0);
+    colorLightingShader.setInt("material.specular", 1);
+    for (unsigned int i = 0; i < sizeof(lightWaves) / sizeof(lightWaves[0]); i++)
+    {
+        std::string wave = "lightWaves[" + std::to_string(i) + "]";
+        colorLightingShader.setVec3(wave + ".amplitude", lightWaves[i].amplitude);
+        colorLightingShader.setVec3(wave + ".bias", lightWaves[i].bias);
+        colorLightingShader.setFloat(wave + ".frequency", lightWaves[i].frequency);
+        colorLightingShader.setFloat(wave + ".phase", lightWaves[i].phase);
+    }
+    int appliedLightMode = -1;
+
+    // the light parameters, shared by the GL programs and the reference renderer
+    SpecularLighting lighting;
+    lighting.shininess = 32.0f;
+    lighting.dirLight = { glm::vec3(-0.2f, -1.0f, -0.3f), glm::vec3(0.05f), glm::vec3(0.4f), glm::vec3(0.5f) };
+    for (int i = 0; i < shadedLights; i++)
+        lighting.pointLights.push_back({ i < 4 ? pointLightPositions[i] : stressLights[i - 4], 1.0f, 0.09f, 0.032f, glm::vec3(0.05f), glm::vec3(0.8f), glm::vec3(1.0f) });
+    lighting.spotLight = { glm::cos(glm::radians(12.5f)), glm::cos(glm::radians(15.0f)), 1.0f, 0.09f, 0.032f, glm::vec3(0.0f), glm::vec3(1.0f), glm::vec3(1.0f) };
+
+    // light parameters never change, so they are uploaded once per lighting variant
+    ShaderProgram* lightingVariants[] = { &whiteLightingShader, &colorLightingShader };
+    for (ShaderProgram* variant : lightingVariants)
+    {
+        ProfileScope scope("lighting uniforms");
+        variant->use();
+        variant->setFloat("material.shininess", lighting.shininess);
         // directional light
-        lightingShader.setVec3("dirLight.direction", -0.2f, -1.0f, -0.3f);
-        lightingShader.setVec3("dirLight.ambient", 0.05f, 0.05f, 0.05f);
-        lightingShader.setVec3("dirLight.diffuse", 0.4f, 0.4f, 0.4f);
-        lightingShader.setVec3("dirLight.specular", 0.5f, 0.5f, 0.5f);
-        // point light 1
-        lightingShader.setVec3("pointLights[0].position", pointLightPositions[0]);
-        lightingShader.setVec3("pointLights[0].ambient", 0.05f, 0.05f, 0.05f);
-        lightingShader.setVec3("pointLights[0].diffuse", 0.8f, 0.8f, 0.8f);
-        lightingShader.setVec3("pointLights[0].specular", 1.0f, 1.0f, 1.0f);
-        lightingShader.setFloat("pointLights[0].constant", 1.0f);
-        lightingShader.setFloat("pointLights[0].linear", 0.09f);
-        lightingShader.setFloat("pointLights[0].quadratic", 0.032f);
-        // point light 2
-        lightingShader.setVec3("pointLights[1].position", pointLightPositions[1]);
-        lightingShader.setVec3("pointLights[1].ambient", 0.05f, 0.05f, 0.05f);
-        lightingShader.setVec3("pointLights[1].diffuse", 0.8f, 0.8f, 0.8f);
-        lightingShader.setVec3("pointLights[1].specular", 1.0f, 1.0f, 1.0f);
-        lightingShader.setFloat("pointLights[1].constant", 1.0f);
-        lightingShader.setFloat("pointLights[1].linear", 0.09f);
-        lightingShader.setFloat("pointLights[1].quadratic", 0.032f);
-        // point light 3
-        lightingShader.setVec3("pointLights[2].position", pointLightPositions[2]);
-        lightingShader.setVec3("pointLights[2].ambient", 0.05f, 0.05f, 0.05f);
-        lightingShader.setVec3("pointLights[2].diffuse", 0.8f, 0.8f, 0.8f);
-        lightingShader.setVec3("pointLights[2].specular", 1.0f, 1.0f, 1.0f);
-        lightingShader.setFloat("pointLights[2].constant", 1.0f);
-        lightingShader.setFloat("pointLights[2].linear", 0.09f);
-        lightingShader.setFloat("pointLights[2].quadratic", 0.032f);
-        // point light 4
-        lightingShader.setVec3("pointLights[3].position", pointLightPositions[3]);
-        lightingShader.setVec3("pointLights[3].ambient", 0.05f, 0.05f, 0.05f);
-        lightingShader.setVec3("pointLights[3].diffuse", 0.8f, 0.8f, 0.8f);
-        lightingShader.setVec3("pointLights[3].specular", 1.0f, 1.0f, 1.0f);
-        lightingShader.setFloat("pointLights[3].constant", 1.0f);
-        lightingShader.setFloat("pointLights[3].linear", 0.09f);
-        lightingShader.setFloat("pointLights[3].quadratic", 0.032f);
-        // spotLight
-        lightingShader.setVec3("spotLight.position", camera.Position);
-        lightingShader.setVec3("spotLight.direction", camera.Front);
-        lightingShader.setVec3("spotLight.ambient", 0.0f, 0.0f, 0.0f);
-        lightingShader.setVec3("spotLight.diffuse", 1.0f, 1.0f, 1.0f);
-        lightingShader.setVec3("spotLight.specular", 1.0f, 1.0f, 1.0f);
-        lightingShader.setFloat("spotLight.constant", 1.0f);
-        lightingShader.setFloat("spotLight.linear", 0.09f);
-        lightingShader.setFloat("spotLight.quadratic", 0.032f);
-        lightingShader.setFloat("spotLight.cutOff", glm::cos(glm::radians(12.5f)));
-        lightingShader.setFloat("spotLight.outerCutOff", glm::cos(glm::radians(15.0f)));
-        // view/projection 
-        glm::mat4 projection = glm::perspective(glm::radians(camera.Zoom), (float)SCR_WIDTH / (float)SCR_HEIGHT, 0.1f, 100.0f);
-        glm::mat4 view = camera.GetViewMatrix();
-        lightingShader.setMat4("projection", projection);
-        lightingShader.setMat4("view", view);
-
-        // world transformation
-        glm::mat4 model = glm::mat4(1.0f);
-        lightingShader.setMat4("model", model);
-
-        float angle = 0.0;
-        float ambient[] = { 0.5f, 0.5f, 0.5f, 1 };
-        float diffuse[] = { 0.8f, 0.8f, 0.8f, 1 };
-        float specular[] = { 1.0f, 1.0f, 1.0f, 1 };
-        float shininess = 128;
-        glMaterialfv(GL_FRONT, GL_AMBIENT, ambient);
-        glMaterialfv(GL_FRONT, GL_DIFFUSE, diffuse);
-        glMaterialfv(GL_FRONT, GL_SPECULAR, specular);
-        glMaterialf(GL_FRONT, GL_SHININESS, shininess);
-    
-        glBindVertexArray(compassVAO);
-        model = glm::mat4(1.0f);
-
-        model = glm::rotate(model, glm::radians(240.0f), glm::vec3(0.01f, 0.01f, 0.01f));
-        model = glm::translate(model, glm::vec3(0.14f, -0.2f, .467f)); //(forward .14, left .2, up..467)
-        model = glm::scale(model, glm::vec3(1.1f)); // Make it a smaller cube
-        model = glm::scale(model, glm::vec3(.75f, .75f, .25f));
-        lightingShader.setMat4("model", model);
-        glActiveTexture(GL_TEXTURE0);
-        glBindTexture(GL_TEXTURE_2D, compassTexture);
-        glDrawArrays(GL_TRIANGLES, 0, 36);
-        glBindVertexArray(0);
-      
-
-
-        lightingShader.setInt("spriteColor", 3);
-        int vertexColorLocation = glGetUniformLocation(lightingShader.ID, "fragColor");
-
-        angle = 0.0;
-        if (redLight)
+        variant->setVec3("dirLight.direction", lighting.dirLight.direction);
+        variant->setVec3("dirLight.ambient", lighting.dirLight.ambient);
+        variant->setVec3("dirLight.diffuse", lighting.dirLight.diffuse);
+        variant->setVec3("dirLight.specular", lighting.dirLight.specular);
+        // point lights
+        for (int i = 0; i < shadedLights; i++)
         {
-            double  timeValue = glfwGetTime();
-            float greenValue = static_cast<float>(sin(timeValue) / 2.0 + 0.5);
-            float blueValue = static_cast<float>(sin(timeValue) / 2.0 + 0.5);
-            float redValue = static_cast<float>(sin(timeValue) / 2.0 + 0.5);
+            const SpecularLighting::PointLight& pointLight = lighting.pointLights[i];
+            std::string light = "pointLights[" + std::to_string(i) + "]";
+            variant->setVec3(light + ".position", pointLight.position);
+            variant->setVec3(light + ".ambient", pointLight.ambient);
+            variant->setVec3(light + ".diffuse", pointLight.diffuse);
+            variant->setVec3(light + ".specular", pointLight.specular);
+            variant->setFloat(light + ".constant", pointLight.constant);
+            variant->setFloat(light + ".linear", pointLight.linear);
+            variant->setFloat(light + ".quadratic", pointLight.quadratic);
+        }
+        // spotLight, follows the camera
+        variant->setVec3("spotLight.ambient", lighting.spotLight.ambient);
+        variant->setVec3("spotLight.diffuse", lighting.spotLight.diffuse);
+        variant->setVec3("spotLight.specular", lighting.spotLight.specular);
+        variant->setFloat("spotLight.constant", lighting.spotLight.constant);
+        variant->setFloat("spotLight.linear", lighting.spotLight.linear);
+        variant->setFloat("spotLight.quadratic", lighting.spotLight.quadratic);
+        variant->setFloat("spotLight.cutOff", lighting.spotLight.cutOff);
+        variant->setFloat("spotLight.outerCutOff", lighting.spotLight.outerCutOff);
+    }
 
+    // the extra asset stands on the desk top
+    BinaryModel* extraModel = modelPath ? new BinaryModel(modelPath, loadTexture) : NULL;
+    if (extraModel && !extraModel->Loaded())
+    {
+        delete extraModel;
+        extraModel = NULL;
+    }
+    TransformSystem::Handle extraModelTransform = transforms.Add(glm::vec3(0.0f, 0.75f, 0.0f), glm::quat(1.0f, 0.0f, 0.0f, 0.0f), glm::vec3(1.0f));
+
+    // a distant pen skips its small parts once they are only a pixel or two across: the clip
+    // below 2% of the screen height, the accent and point below 1%. The body is always drawn
+    // at full tessellation; pen_body.h offers no coarser mesh, so this saves draw calls and
+    // the small parts' vertices, not the body's
+    LodSelector penLod({ 0.02f, 0.01f });
+    const float penRadius = 0.5f;
+    int penLodLevel = 0;
+
+    // the scene, in the order it has always been drawn
+    std::vector<SceneObject> litObjects;
+    std::vector<std::size_t> roomParts, deskParts;   // what the stress test copies, by index
+    litObjects.push_back({ compassTransform, NULL, compassVAO, compassTexture, 36, 0, 1.25f, NULL, NULL });
+    roomParts.push_back(litObjects.size());
+    litObjects.push_back({ blackboardTransform, NULL, blackboardVAO, blackboardTexture, 36, 0, 0.87f, NULL, NULL });
+    unsigned int deskTextures[10] = { 0, deskTexture, redTexture, blueTexture, lightgreyTexture, greyTexture, greyTexture, greyTexture, greyTexture, purpleTexture };
+    for (unsigned int i = 1; i < 10; i++)  // desk
+    {
+        deskParts.push_back(litObjects.size());
+        litObjects.push_back({ deskTransforms[i], NULL, bookVAO, deskTextures[i], 36, 0, 0.87f, NULL, NULL });
+    }
+    roomParts.push_back(litObjects.size());
+    litObjects.push_back({ groundTransform, NULL, groundVAO, groundTexture, 36, 0, 0.87f, NULL, NULL });
+    const std::size_t penFirst = litObjects.size();
+    litObjects.push_back({ 0, &penModel, 0, metalTexture, 0, 0, 0.0f, DrawObject<PenBody>, penBody.get(), &penLodLevel, static_cast<int>(penLod.LevelCount()) - 1 });
+    litObjects.push_back({ 0, &penModel, 0, metalTexture, 0, 0, 0.0f, DrawObject<PenClip>, penClip.get(), &penLodLevel, 0 });
+    litObjects.push_back({ 0, &penModel, 0, metalTexture, 0, 0, 0.0f, DrawObject<PenAccent>, sphereAccent.get(), &penLodLevel, 1 });
+    litObjects.push_back({ 0, &penModel, 0, ballpointTexture, 0, 0, 0.0f, DrawObject<PenPoint>, penPoint.get(), &penLodLevel, 1 });
+    for (std::size_t i = penFirst; i < litObjects.size(); i++)
+        deskParts.push_back(i);
+    if (extraModel)
+        litObjects.push_back({ extraModelTransform, NULL, 0, 0, 0, 0, extraModel->Radius(), DrawObject<BinaryModel>, extraModel });
+    roomParts.push_back(litObjects.size());
+    litObjects.push_back({ skyboxTransform, NULL, skyboxVAO, skyboxTexture, 36, 0, 0.87f, NULL, NULL });
+
+    // light cubes, grouped by the shader that draws them; cubes 1 and 2 also get a purple
+    // draw that loses the depth test, as they always have
+    ShaderProgram* cubeShaders[] = { &greenShader, &pinkShader, &purpleShader, &whiteShader };
+    const int GREEN = 0, PINK = 1, PURPLE = 2, WHITE = 3;
+    std::vector<SceneObject> lightCubeObjects;
+    for (unsigned int i = 0; i < 6; i++)
+    {
+        int shader = whiteLights ? GREEN : ((i == 1 || i == 2) ? GREEN : (i >= 3 ? PINK : PURPLE));
+        lightCubeObjects.push_back({ lightCubeTransforms[i], NULL, cubeVAO, 0, 36, shader, 0.87f, NULL, NULL });
+    }
+    if (!whiteLights)
+    {
+        lightCubeObjects.push_back({ lightCubeTransforms[1], NULL, cubeVAO, 0, 36, PURPLE, 0.87f, NULL, NULL });
+        lightCubeObjects.push_back({ lightCubeTransforms[2], NULL, cubeVAO, 0, 36, PURPLE, 0.87f, NULL, NULL });
+    }
 
-            glm::vec4 fragColor = glm::vec4(redValue, 0.0f, 0.0f, 1.0f);
-            lightingShader.setVec3("spriteColor", fragColor);
-        }
-        if (blueLight)
-        {
-            double timeValue = glfwGetTime();
-            float greenValue = static_cast<float>(sin(timeValue) / 2.0 + 0.5);
-            float blueValue = static_cast<float>(sin(timeValue) / 2.0 + 0.5);
-            float redValue = static_cast<float>(sin(timeValue) / 2.0 + 0.5);
+    // everything so far stands in the classroom
+    for (SceneObject& object : litObjects)
+        object.cell = 0;
+    for (SceneObject& cube : lightCubeObjects)
+        cube.cell = 0;
 
+    // the generated building: copies of the room (blackboard, ground, walls) and of the
+    // desk with its pen, plus a white cube for every extra light
+    std::deque<LodGroup> stressLodGroups;
+    if (stressConfig.Enabled())
+    {
+        std::vector<SceneObject> roomTemplate, deskTemplate;
+        for (std::size_t i : roomParts)
+            roomTemplate.push_back(litObjects[i]);
+        for (std::size_t i : deskParts)
+            deskTemplate.push_back(litObjects[i]);
+        for (unsigned int room = 1; room < stressLayout.RoomCount(); room++)
+            CloneObjects(roomTemplate, transforms, transforms.Add(stressLayout.RoomOffset(room), glm::quat(1.0f, 0.0f, 0.0f, 0.0f), glm::vec3(1.0f)), litObjects, stressLodGroups, penRadius,
+                         static_cast<int>(room));
+        for (unsigned int row = 0; row < stressConfig.rows; row++)
+        {
+            for (unsigned int column = 0; column < stressConfig.columns; column++)
+                CloneObjects(deskTemplate, transforms, transforms.Add(stressLayout.DeskOffset(row, column), glm::quat(1.0f, 0.0f, 0.0f, 0.0f), glm::vec3(1.0f)), litObjects, stressLodGroups, penRadius,
+                             static_cast<int>(stressLayout.DeskRoom(row, column)));
+        }
+    }
+    for (unsigned int i = 0; i < stressLights.size(); i++)
+    {
+        lightCubeObjects.push_back({ transforms.Add(stressLights[i], glm::quat(1.0f, 0.0f, 0.0f, 0.0f), glm::vec3(0.4f)), NULL, cubeVAO, 0, 36, WHITE, 0.87f, NULL, NULL });
+        lightCubeObjects.back().cell = static_cast<int>(stressLayout.LightRoom(i));
+    }
 
-            glm::vec4 fragColor = glm::vec4(0.0f, 0.0f, blueValue, 1.0f);
-            lightingShader.setVec3("spriteColor", fragColor);
+    // one model matrix per draw and occlusion box plus the frame's projection/view, triple-buffered
+    const std::size_t occlusionBoxes = occlusionCulling ? litObjects.size() : 0;
+    UniformRing* uniformRing = new UniformRing(static_cast<unsigned int>(litObjects.size() + occlusionBoxes + lightCubeObjects.size() + 1), 2 * sizeof(glm::mat4));
+    Frustum frustum;
+    // transient per-frame data; drawScene hands these fresh arena storage every frame
+    FrameArena frameArena(1 << 20);
+    FrameVector<char> litVisible;
+    DrawList litCommands;
+    DrawList lightBins[4];
+    OcclusionCulling* occlusion = occlusionCulling ? new OcclusionCulling(static_cast<unsigned int>(litObjects.size())) : NULL;
+
+    // spatial index over the lit objects for picking; the pens get their LOD radius
+    transforms.UpdateWorld();
+    std::vector<Aabb> objectBoxes(litObjects.size());
+    for (unsigned int i = 0; i < litObjects.size(); i++)
+        objectBoxes[i] = ObjectBox(litObjects[i], transforms, penRadius);
+    Bvh sceneIndex;
+    sceneIndex.Build(objectBoxes);
+
+    // rows of pixels the scene is rendered at this frame, which the texture mips are picked for
+    float viewportHeight = SCR_HEIGHT;
+    TaskGraph frameGraph;
+    TaskGraph::Task transformTask = frameGraph.Add([&]() {
+        ProfileScope scope("transforms");
+        transforms.UpdateWorld();
+    });
+    TaskGraph::Task lodTask = frameGraph.Add([&]() {
+        ProfileScope scope("lod");
+        penLodLevel = penLod.Select(ProjectedSize(glm::vec3(penModel[3]) / penModel[3][3], penRadius, camera.Position, glm::radians(camera.Zoom)), penLodLevel);
+        for (LodGroup& group : stressLodGroups)
+            group.level = penLod.Select(ProjectedSize(glm::vec3(transforms.World(group.transform)[3]), group.radius, camera.Position, glm::radians(camera.Zoom)), group.level);
+    });
+    TaskGraph::Task indexTask = frameGraph.Add([&]() {
+        ProfileScope scope("scene index");
+        // refit around whatever moved, rebuilding once the tree has loosened too far
+        for (unsigned int i = 0; i < litObjects.size(); i++)
+        {
+            Aabb box = ObjectBox(litObjects[i], transforms, penRadius);
+            if (box != sceneIndex.ItemBox(i))
+                sceneIndex.Update(i, box);
         }
-        if (purpleLight)
+        sceneIndex.RebuildIfDegraded();
+    });
+    TaskGraph::Task portalTask = frameGraph.Add([&]() {
+        ProfileScope scope("portals");
+        if (portalCulling)
+            rooms.Update(camera.Position, frustum, &frameArena);
+    });
+    TaskGraph::Task visibilityTask = frameGraph.Add([&]() {
+        ProfileScope scope("visibility");
+        jobs.ParallelFor(static_cast<unsigned int>(litObjects.size()), 64, [&](unsigned int begin, unsigned int end) {
+            for (unsigned int i = begin; i < end; i++)
+                litVisible[i] = rooms.CellVisible(litObjects[i].cell) && ObjectVisible(litObjects[i], transforms, frustum);
+        });
+    });
+    TaskGraph::Task lightTask = frameGraph.Add([&]() {
+        ProfileScope scope("light bins");
+        for (const SceneObject& cube : lightCubeObjects)
         {
-            double timeValue = glfwGetTime();
-            float greenValue = static_cast<float>(sin(timeValue) / 2.0 + 0.5);
-            float blueValue = static_cast<float>(sin(timeValue) / 2.0 + 0.5);
-            float redValue = static_cast<float>(sin(timeValue) / 2.0 + 0.5);
+            if (rooms.CellVisible(cube.cell) && ObjectVisible(cube, transforms, frustum))
+                MakeCommand(cube, transforms, *uniformRing, lightBins[cube.shader]);
+        }
+    });
+    TaskGraph::Task buildTask = frameGraph.Add([&]() {
+        ProfileScope scope("command lists");
+        for (unsigned int i = 0; i < litObjects.size(); i++)
+        {
+            if (!litVisible[i])
+                continue;
+            if (occlusion)
+                occlusion->PrepareQuery(i, litObjects[i], transforms, camera.Position, *uniformRing);
+            if (!MakeCommand(litObjects[i], transforms, *uniformRing, litCommands))
+                continue;
+            if (occlusion)
+                litCommands.back().occlusionQuery = occlusion->QueryFor(i, litObjects[i], transforms, camera.Position);
+            if (litObjects[i].texture)
+                textureStreamer.Request(litObjects[i].texture, ObjectScreenSize(litObjects[i], transforms, camera.Position, glm::radians(camera.Zoom)) * viewportHeight);
+        }
+    });
+    frameGraph.DependsOn(lodTask, transformTask);
+    frameGraph.DependsOn(indexTask, transformTask);
+    frameGraph.DependsOn(visibilityTask, lodTask);
+    frameGraph.DependsOn(visibilityTask, portalTask);
+    frameGraph.DependsOn(lightTask, transformTask);
+    frameGraph.DependsOn(lightTask, portalTask);
+    frameGraph.DependsOn(buildTask, visibilityTask);
+
+    startup.Mark("scene setup");
+
+    // the first frame drawn on the CPU instead, from the same tables, textures and lights
+    if (referencePath)
+    {
+        std::map<unsigned int, SoftwareMesh> meshFor = {
+            { blackboardVAO, { blackboard, sizeof(blackboard) / (8 * sizeof(float)), 8 } },
+            { compassVAO, { compassVertices, sizeof(compassVertices) / (8 * sizeof(float)), 8 } },
+            { bookVAO, { vertices, sizeof(vertices) / (8 * sizeof(float)), 8 } },
+            { skyboxVAO, { vertices, sizeof(vertices) / (8 * sizeof(float)), 8 } },
+            { groundVAO, { groundVertices, sizeof(groundVertices) / (8 * sizeof(float)), 8 } },
+            { cubeVAO, { lightvertices, sizeof(lightvertices) / (3 * sizeof(float)), 3 } },
+        };
+        const unsigned int textureIds[TEXTURE_COUNT] = { redTexture, blueTexture, lightgreyTexture, compassTexture, skyboxTexture, blackboardTexture,
+                                                         groundTexture, greyTexture, purpleTexture, metalTexture, deskTexture, ballpointTexture };
+        std::map<unsigned int, const SoftwareTexture*> textureFor;
+        for (unsigned int i = 0; i < TEXTURE_COUNT; i++)
+            textureFor[textureIds[i]] = softwareTextures[i].get();
+        // white.fs's color; green.fs, pink.fs and purple.fs are approximated
+        const glm::vec3 cubeColors[] = { glm::vec3(0.0f, 1.0f, 0.0f), glm::vec3(1.0f, 0.4f, 0.7f), glm::vec3(0.5f, 0.0f, 0.5f), glm::vec3(0.89f) };
+
+        // objects that draw themselves (the pens, --model) have no table and are left out;
+        // texture unit 1 is never bound, so the specular maps sample black as in GL
+        std::vector<SoftwareDraw> softwareDraws;
+        for (const SceneObject& object : litObjects)
+        {
+            if (object.draw || !meshFor.count(object.vao))
+                continue;
+            SoftwareMesh mesh = meshFor[object.vao];
+            mesh.vertexCount = std::min(mesh.vertexCount, object.vertexCount);
+            softwareDraws.push_back({ mesh, ObjectModel(object, transforms), textureFor[object.texture], NULL, true, glm::vec3(0.0f) });
+        }
+        for (const SceneObject& cube : lightCubeObjects)
+            softwareDraws.push_back({ meshFor[cube.vao], ObjectModel(cube, transforms), NULL, NULL, false, cubeColors[cube.shader] });
+
+        auto referenceStart = std::chrono::steady_clock::now();
+        SoftwareRasterizer rasterizer(referenceWidth, referenceHeight);
+        glm::mat4 projection = glm::perspective(glm::radians(camera.Zoom), static_cast<float>(referenceWidth) / referenceHeight, 0.1f, 100.0f);
+        rasterizer.Render(jobs, softwareDraws, projection, camera.GetViewMatrix(), camera.Position, camera.Front, lighting, lightTint(lightMode, 0.0f),
+                          glm::vec3(0.1f));
+        double referenceMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - referenceStart).count();
+        if (WriteTga(referencePath, referenceWidth, referenceHeight, rasterizer.Pixels()))
+            std::cout << "Reference image: " << referencePath << " (" << referenceWidth << "x" << referenceHeight << ", " << softwareDraws.size() << " draws, " << referenceMs << " ms)" << std::endl;
+        else
+            std::cout << "Cannot write " << referencePath << std::endl;
+        glfwSetWindowShouldClose(window, true);
+    }
+    // GPU ranges of the frame, next to the CPU scopes in the trace
+    GpuTimeline* gpuTimeline = new GpuTimeline();
 
+    // one frame of the scene from the current camera into the bound framebuffer; returns the draw calls
+    auto drawScene = [&](float aspect, float time, float targetHeight) -> unsigned int {
+        Profiler().BeginFrame();
+        viewportHeight = targetHeight;
+        gpuTimeline->BeginFrame();
+        // mode 0 is plain white light, which has its own variant without the color animation
+        ShaderProgram& lightingShader = lightMode == 0 ? whiteLightingShader : colorLightingShader;
 
-            glm::vec4 fragColor = glm::vec4(redValue, 0.0f, blueValue, 1.0f);
-            lightingShader.setVec3("spriteColor", fragColor);
+        // view/projection 
+        glm::mat4 projection = glm::perspective(glm::radians(camera.Zoom), aspect, 0.1f, 100.0f);
+        glm::mat4 view = camera.GetViewMatrix();
+        frustum = Frustum::FromMatrix(projection * view);
+
+        // last frame's lists stay valid in the other half of the arena
+        frameArena.BeginFrame();
+        litVisible = FrameVector<char>(litObjects.size(), 0, FrameAllocator<char>(&frameArena));
+        litCommands = DrawList(FrameAllocator<DrawCommand>(&frameArena));
+        litCommands.reserve(litObjects.size());
+        for (DrawList& bin : lightBins)
+        {
+            bin = DrawList(FrameAllocator<DrawCommand>(&frameArena));
+            bin.reserve(lightCubeObjects.size());
         }
-        if (noLight)
-        
+
+        uniformRing->BeginFrame();
+        glm::mat4 frameMatrices[] = { projection, view };
+        GLintptr matricesOffset = uniformRing->Push(frameMatrices, sizeof(frameMatrices));
         {
-            glm::vec4 fragColor = glm::vec4(1.0f, 1.0f, 1.0f, 1.0f);
-            lightingShader.setVec3("spriteColor", fragColor);
+            ProfileScope scope("frame graph");
+            frameGraph.Run(jobs);
         }
-        
+        uniformRing->Flush();
+        glBindBufferRange(GL_UNIFORM_BUFFER, MATRICES_BINDING, uniformRing->Buffer(), matricesOffset, sizeof(frameMatrices));
 
-        glBindVertexArray(blackboardVAO);
-        model = glm::mat4(1.0f);
-        model = glm::rotate(model, glm::radians(angle), glm::vec3(3.01f, 0.01f, -11.01f));
-        model = glm::translate(model, glm::vec3(0.0f, 1.5f, -3.67f));
-        model = glm::scale(model, glm::vec3(4.0f, 4.0f, 4.0f));
-        lightingShader.setMat4("model", model);
-        glActiveTexture(GL_TEXTURE0);
-        glBindTexture(GL_TEXTURE_2D, blackboardTexture);
-        glDrawArrays(GL_TRIANGLES, 0, 36);
-        glBindVertexArray(0);
+        glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
+        lightingShader.use();
+        lightingShader.setVec3("viewPos", camera.Position);
+        lightingShader.setVec3("spotLight.position", camera.Position);
+        lightingShader.setVec3("spotLight.direction", camera.Front);
 
-        glBindVertexArray(bookVAO);
-        for (unsigned int i = 0; i < 10; i++)  // desk
+        // the shader animates the light color; switching modes only updates one integer
+        lightingShader.setFloat("time", time);
+        if (lightMode != appliedLightMode)
         {
-            glm::mat4 model = glm::mat4(1.0f);
-            if (i == 1)
-            {
-                model = glm::rotate(model, glm::radians(angle), glm::vec3(0.01f, 0.01f, 0.01f));
-                model = glm::translate(model, glm::vec3(0.0f, 0.0f, 0.0f));
-                model = glm::scale(model, glm::vec3(1.8f, 1.2f, 1.5f));
-                lightingShader.setMat4("model", model);
-                glActiveTexture(GL_TEXTURE0);
-                glBindTexture(GL_TEXTURE_2D, deskTexture);
-                glDrawArrays(GL_TRIANGLES, 0, 36);
-            }
-            if (i == 2)
-            {
-                model = glm::rotate(model, glm::radians(angle), glm::vec3(0.01f, 0.01f, 0.01f));
-                model = glm::translate(model, glm::vec3(0.0f, .62f, 0.05f));
-                model = glm::scale(model, glm::vec3(.4f, .035f, .6f));
-                lightingShader.setMat4("model", model);
-                glActiveTexture(GL_TEXTURE0);
-                glBindTexture(GL_TEXTURE_2D, redTexture);
-                glDrawArrays(GL_TRIANGLES, 0, 36);
-            }
-            if (i == 3)
-            {
-                model = glm::rotate(model, glm::radians(angle), glm::vec3(0.01f, -1.1f, 0.01f));
-                model = glm::translate(model, glm::vec3(0.0f, .695f, 0.03f));
-                model = glm::scale(model, glm::vec3(.4f, .035f, .4f));
-                lightingShader.setMat4("model", model);
-                glActiveTexture(GL_TEXTURE0);
-                glBindTexture(GL_TEXTURE_2D, blueTexture);
-                glDrawArrays(GL_TRIANGLES, 0, 36);
-            }
-            if (i == 4)
-            {
-                model = glm::rotate(model, glm::radians(angle), glm::vec3(0.01f, 0.01f, 0.01f));
-                model = glm::translate(model, glm::vec3(-.5f, .64f, 0.0285f));
-                model = glm::scale(model, glm::vec3(.4f, .07f, .5f));
-                lightingShader.setMat4("model", model);
-                glActiveTexture(GL_TEXTURE0);
-                glBindTexture(GL_TEXTURE_2D, lightgreyTexture);
-                glDrawArrays(GL_TRIANGLES, 0, 36);
-            }
-            if (i == 5)
-            {
-                model = glm::rotate(model, glm::radians(angle), glm::vec3(0.01f, 0.01f, 0.01f));
-                model = glm::translate(model, glm::vec3(-.5f, .605f, 0.03f));
-                model = glm::scale(model, glm::vec3(.41f, .01f, .51f));
-                lightingShader.setMat4("model", model);
-                glActiveTexture(GL_TEXTURE0);
-                glBindTexture(GL_TEXTURE_2D, greyTexture);
-                glDrawArrays(GL_TRIANGLES, 0, 36);
-            }
-            if (i == 6)
-            {
-                model = glm::rotate(model, glm::radians(angle), glm::vec3(0.01f, 0.01f, 0.01f));
-                model = glm::translate(model, glm::vec3(-.50f, .678f, 0.03f));
-                model = glm::scale(model, glm::vec3(.41f, .01f, .51f));
-                lightingShader.setMat4("model", model);
-                glActiveTexture(GL_TEXTURE0);
-                glBindTexture(GL_TEXTURE_2D, greyTexture);
-                glDrawArrays(GL_TRIANGLES, 0, 36);
-            }
-            if (i == 7)
-            {
-                model = glm::rotate(model, glm::radians(angle), glm::vec3(0.01f, 0.01f, 0.01f));
-                model = glm::translate(model, glm::vec3(-.3f, .639f, 0.03f));
-                model = glm::scale(model, glm::vec3(.01f, .07f, .51f));
-                lightingShader.setMat4("model", model);
-                glActiveTexture(GL_TEXTURE0);
-                glBindTexture(GL_TEXTURE_2D, greyTexture);
-                glDrawArrays(GL_TRIANGLES, 0, 36);
-            }
-            if (i == 8)
-            {
-                angle = 7.0f;
-                glm::mat4 model = glm::mat4(1.0f);
-                model = glm::rotate(model, glm::radians(angle), glm::vec3(0.00f, -.08f, 0.00f));
-                model = glm::translate(model, glm::vec3(-.50f, .7f, 0.05));
-                model = glm::scale(model, glm::vec3(.31f, .03f, .41f));
-                lightingShader.setMat4("model", model);
-                glActiveTexture(GL_TEXTURE0);
-                glBindTexture(GL_TEXTURE_2D, greyTexture);
-                glDrawArrays(GL_TRIANGLES, 0, 36);
-            }
-            if (i == 9)
-            {
-                angle = -9;
-                glm::mat4 model = glm::mat4(1.0f);
-
-                model = glm::rotate(model, glm::radians(angle), glm::vec3(0.00f, 1.00f, 0.0f));
-                model = glm::translate(model, glm::vec3(0.0f, .66f, 0.03f));
-                model = glm::scale(model, glm::vec3(.4f, .035f, .6f));
-                lightingShader.setMat4("model", model);
-                glActiveTexture(GL_TEXTURE0);
-                glBindTexture(GL_TEXTURE_2D, purpleTexture);
-                glDrawArrays(GL_TRIANGLES, 0, 36);
-            }
+            lightingShader.setInt("lightMode", lightMode);
+            appliedLightMode = lightMode;
         }
-        glBindVertexArray(0);
-       
-        angle = 0.0f;
-        glBindVertexArray(groundVAO);
-        for (unsigned int i = 0; i < 1; i++)
-        model = glm::rotate(model, glm::radians(angle), glm::vec3(0.001f, 0.001f, 0.0001f));
-        model = glm::translate(model, glm::vec3(0.0f, -4.1f, -0.3f));
-        model = glm::scale(model, glm::vec3(7.0f));
-        lightingShader.setMat4("model", model);
-        glActiveTexture(GL_TEXTURE0);
-        glBindTexture(GL_TEXTURE_2D, groundTexture);
-        glDrawArrays(GL_TRIANGLES, 0, 36);
-        glBindVertexArray(0);
-
-        glActiveTexture(GL_TEXTURE0);
-        glBindTexture(GL_TEXTURE_2D, metalTexture);
-        // keep this texture bound for the next 3 objects
-        model = glm::mat4(0.5f);
-        lightingShader.setMat4("model", model);
-        model = glm::mat4(0.5f);
-        model = glm::rotate(model, glm::radians(angle), glm::vec3(0.01f, 0.01f, 0.01f));
-        model = glm::translate(model, glm::vec3(2.0f, 1.0f, 2.0f));
-        PenBody penBody;
-        penBody.Draw();
-
-        model = glm::mat4(0.5f);
-        lightingShader.setMat4("model", model);
-        model = glm::mat4(0.5f);
-        model = glm::rotate(model, glm::radians(angle), glm::vec3(0.01f, 0.01f, 0.01f));
-        model = glm::translate(model, glm::vec3(2.0f, 1.0f, 2.0f));
-        PenClip penClip;
-        penClip.Draw();
-
-        model = glm::mat4(0.5f);
-        model = glm::mat4(0.5f);
-        lightingShader.setMat4("model", model);
-        model = glm::mat4(0.5f);
-        model = glm::rotate(model, glm::radians(angle), glm::vec3(0.01f, 0.01f, 0.01f));
-        model = glm::translate(model, glm::vec3(2.0f, 1.0f, 2.0f));
-        PenAccent sphereAccent;
-        sphereAccent.Draw();
-
-
-        glActiveTexture(GL_TEXTURE0);
-        glBindTexture(GL_TEXTURE_2D, ballpointTexture);
-        model = glm::mat4(0.5f);
-        lightingShader.setMat4("model", model);
-        model = glm::mat4(0.5f);
-        model = glm::rotate(model, glm::radians(angle), glm::vec3(0.01f, 0.01f, 0.01f));
-        model = glm::translate(model, glm::vec3(2.0f, 1.0f, 2.0f));
-        PenPoint penPoint;
-        penPoint.Draw();
-
-        glBindVertexArray(skyboxVAO);
-        model = glm::mat4(1.0f);
-        model = glm::rotate(model, glm::radians(angle), glm::vec3(0.01f, 0.01f, 0.01f));
-        model = glm::translate(model, glm::vec3(0.0f, 0.0f, -0.2f));
-        model = glm::scale(model, glm::vec3(7.0f));
-        lightingShader.setMat4("model", model);
-        glActiveTexture(GL_TEXTURE0);
-        glBindTexture(GL_TEXTURE_2D, skyboxTexture);
-        glDrawArrays(GL_TRIANGLES, 0, 36);
-        glBindVertexArray(0);
-
-
-        glBindBuffer(GL_UNIFORM_BUFFER, uboMatrices);
-        glBufferSubData(GL_UNIFORM_BUFFER, sizeof(glm::mat4), sizeof(glm::mat4), glm::value_ptr(view));
-        glBindBuffer(GL_UNIFORM_BUFFER, 0);
-        glBindVertexArray(cubeVAO);
-        for (unsigned int i = 0; i < 6; i++)
+
+        unsigned int drawCalls = 0;
         {
-            if ((i == 2) || (i == 1))
-            {
-                greenShader.use();
-                greenShader.setMat4("projection", projection);
-                greenShader.setMat4("view", view);
-                model = glm::mat4(1.0f);
-                model = glm::translate(model, pointLightPositions[i]);
-                model = glm::scale(model, glm::vec3(0.4f));
-                greenShader.setMat4("model", model);
-                glDrawArrays(GL_TRIANGLES, 0, 36);
-            }
-            if ((i == 3) || (i == 4) || (i == 5))
+            ProfileScope scope("lit objects", gpuTimeline);
+            drawCalls += ReplayCommands(litCommands, *uniformRing);
+        }
+        {
+            ProfileScope scope("light cubes", gpuTimeline);
+            for (unsigned int i = 0; i < 4; i++)
             {
-                pinkShader.use();
-                pinkShader.setMat4("projection", projection);
-                pinkShader.setMat4("view", view);
-                model = glm::mat4(1.0f);
-                model = glm::translate(model, pointLightPositions[i]);
-                model = glm::scale(model, glm::vec3(0.4f));
-                pinkShader.setMat4("model", model);
-                glDrawArrays(GL_TRIANGLES, 0, 36);
+                if (lightBins[i].empty())
+                    continue;
+                cubeShaders[i]->use();
+                drawCalls += ReplayCommands(lightBins[i], *uniformRing);
             }
-            else
+        }
+        // test against this frame's depth; the results gate next frame's draws
+        if (occlusion)
+        {
+            ProfileScope scope("occlusion queries", gpuTimeline);
+            drawCalls += occlusion->IssueQueries(litVisible, *uniformRing, projection * view);
+        }
+        // this frame's coverage decides next frame's mips
+        {
+            ProfileScope scope("texture streaming", gpuTimeline);
+            textureStreamer.Update();
+        }
+        uniformRing->EndFrame();
+        GL_COUNTERS_END_FRAME();
+        return drawCalls;
+    };
+
+    // every pose in every light mode, offscreen, against the goldens and the timing baseline
+    int exitCode = 0;
+    if (regressionPath)
+    {
+        const int FRAMES = 20;  // the first ones let occlusion and LOD settle on the new pose
+        const float STILL_TIME = 1.0f;  // a fixed point of the light color animation
+        OffscreenTarget target(640, 360);
+        RegressionSuite suite(regressionPath, regressionUpdate);
+        unsigned int timer;
+        glGenQueries(1, &timer);
+        for (const RegressionPose& pose : regressionPoses)
+        {
+            for (int mode = 0; mode < 4; mode++)
             {
-                purpleShader.use();
-                purpleShader.setMat4("projection", projection);
-                purpleShader.setMat4("view", view);
-                model = glm::mat4(1.0f);
-                model = glm::translate(model, pointLightPositions[i]);
-                model = glm::scale(model, glm::vec3(0.4f));
-                purpleShader.setMat4("model", model);
-                glDrawArrays(GL_TRIANGLES, 0, 36);
+                camera.Position = pose.position;
+                camera.Yaw = pose.yaw;
+                camera.Pitch = pose.pitch;
+                camera.ProcessMouseMovement(0.0f, 0.0f);  // recomputes Front from yaw and pitch
+                lightMode = mode;
+
+                std::vector<double> cpuMs, gpuMs;
+                for (int frame = 0; frame < FRAMES; frame++)
+                {
+                    target.Bind();
+                    auto cpuStart = std::chrono::steady_clock::now();
+                    glBeginQuery(GL_TIME_ELAPSED, timer);
+                    drawScene(static_cast<float>(target.Width()) / target.Height(), STILL_TIME, static_cast<float>(target.Height()));
+                    glEndQuery(GL_TIME_ELAPSED);
+                    cpuMs.push_back(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - cpuStart).count());
+                    GLuint64 nanoseconds = 0;
+                    glGetQueryObjectui64v(timer, GL_QUERY_RESULT, &nanoseconds);
+                    gpuMs.push_back(nanoseconds / 1.0e6);
+                }
+                const std::string name = std::string(pose.name) + "_mode" + std::to_string(mode);
+                suite.CheckImage(name, target.ReadPixels(), target.Width(), target.Height());
+                // the median of the settled second half
+                std::sort(cpuMs.begin() + FRAMES / 2, cpuMs.end());
+                std::sort(gpuMs.begin() + FRAMES / 2, gpuMs.end());
+                suite.CheckTiming(name, cpuMs[FRAMES * 3 / 4], gpuMs[FRAMES * 3 / 4]);
             }
         }
-        glfwSwapBuffers(window);
+        glDeleteQueries(1, &timer);
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        if (!suite.Finish())
+            exitCode = 1;
+        glfwSetWindowShouldClose(window, true);
+    }
+    // with a frame rate cap the pacer, not vsync, decides when frames start
+    if (targetFps > 0.0 || benchmarkFrames > 0)
+        glfwSwapInterval(0);
+    BenchmarkRun* benchmark = benchmarkFrames > 0 ? new BenchmarkRun(benchmarkFrames) : NULL;
+    double lastSwapTime = glfwGetTime();
+    FramePacer pacer(targetFps);
+    DynamicResolution* dynamicResolution = gpuBudgetMs > 0.0f ? new DynamicResolution(gpuBudgetMs) : NULL;
+    bool firstFrame = true;
+    // frames past the warm-up, when the arena and the job queues have grown to size,
+    // should not allocate; a frame that does is reported, at most every 600 frames
+    const unsigned int ALLOCATION_WARMUP = 120;
+    unsigned int framesDrawn = 0;
+    unsigned int nextAllocationWarning = ALLOCATION_WARMUP;
+    while (!glfwWindowShouldClose(window))
+    {
+        // wait out the frame budget first, then read input as late as possible
+        pacer.WaitForNextFrame();
         glfwPollEvents();
+        pacer.InputSampled();
+
+        float currentFrame = static_cast<float>(glfwGetTime());
+        deltaTime = currentFrame - lastFrame;
+        lastFrame = currentFrame;
+
+        processInput(window);
+
+        // the color modes animate with time; only plain white light is ever still. Textures
+        // still streaming in also need frames to be uploaded
+        bool animating = lightMode != 0 || textureStreamer.Pending();
+        if (onDemand && !sceneDirty && !animating)
+        {
+            // sleep until input arrives; the timeout keeps the close check running
+            glfwWaitEventsTimeout(0.5);
+            lastFrame = static_cast<float>(glfwGetTime());  // keep the wait out of the next deltaTime
+            continue;
+        }
+        sceneDirty = false;
+
+        unsigned long long allocationsBefore = HeapAllocations().load();
+        int framebufferWidth, framebufferHeight;
+        glfwGetFramebufferSize(window, &framebufferWidth, &framebufferHeight);
+        float renderHeight = static_cast<float>(framebufferHeight);
+        if (dynamicResolution)
+        {
+            dynamicResolution->BeginFrame(framebufferWidth, framebufferHeight);
+            renderHeight *= dynamicResolution->Scale();
+        }
+        unsigned int drawCalls = drawScene((float)SCR_WIDTH / (float)SCR_HEIGHT, currentFrame, renderHeight);
+        if (dynamicResolution)
+            dynamicResolution->EndFrame();
+        // objects the last camera move uncovered may have been skipped; draw once more at rest
+        if (occlusion && !occlusion->Settled())
+            sceneDirty = true;
+
+        if (pickRequested)
+        {
+            pickRequested = false;
+            auto pickStart = std::chrono::steady_clock::now();
+            float distance = 0.0f;
+            int picked = sceneIndex.Raycast(camera.Position, camera.Front, 100.0f, [&](unsigned int item, const glm::vec3& origin, const glm::vec3& direction, float maxDistance) {
+                return RayHitsObject(litObjects[item], transforms, sceneIndex.ItemBox(item), origin, direction, maxDistance);
+            }, &distance);
+            double pickMicroseconds = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - pickStart).count();
+            if (picked == Bvh::NO_ITEM)
+                std::cout << "Picked nothing (" << pickMicroseconds << " us)" << std::endl;
+            else
+                std::cout << "Picked object " << picked << " at " << distance << " (" << pickMicroseconds << " us)" << std::endl;
+        }
+        {
+            ProfileScope scope("swap", gpuTimeline);
+            glfwSwapBuffers(window);
+        }
+        unsigned long long frameAllocations = HeapAllocations().load() - allocationsBefore;
+        if (++framesDrawn > nextAllocationWarning && frameAllocations > 0)
+        {
+            std::cout << "WARNING::FRAME_ARENA:: frame " << framesDrawn << " made " << frameAllocations << " heap allocations (arena "
+                      << frameArena.UsedBytes() << " of " << frameArena.CapacityBytes() << " bytes)" << std::endl;
+            nextAllocationWarning = framesDrawn + 600;
+        }
+        if (memoryReportRequested)
+        {
+            memoryReportRequested = false;
+            GpuMemory().Report();
+            textureStreamer.Report();
+        }
+        if (traceRequested)
+        {
+            traceRequested = false;
+            std::string tracePath = "trace_" + std::to_string(Profiler().Frame()) + ".json";
+            if (Profiler().WriteChromeTrace(tracePath, traceFrames))
+                std::cout << "Trace of the last " << traceFrames << " frames: " << tracePath << std::endl;
+            else
+                std::cout << "Cannot write " << tracePath << std::endl;
+        }
+        pacer.Presented();
+        double swapTime = glfwGetTime();
+        if (benchmark && benchmark->Frame((swapTime - lastSwapTime) * 1000.0, drawCalls))
+        {
+            benchmark->Write(benchmarkCsv, stressLayout.RoomCount(), 1 + stressConfig.rows * stressConfig.columns, static_cast<unsigned int>(stressLights.size()),
+                             static_cast<unsigned int>(litObjects.size() + lightCubeObjects.size()));
+            glfwSetWindowShouldClose(window, true);
+        }
+        lastSwapTime = swapTime;
+        double frameMs, latencyMs;
+        if (pacer.Report(frameMs, latencyMs))
+        {
+            char title[128];
+            if (dynamicResolution)
+                std::snprintf(title, sizeof(title), "Classroom Scene - %.2f ms/frame, input to present %.2f ms, GPU %.2f ms at %d%%", frameMs, latencyMs, dynamicResolution->GpuMilliseconds(), static_cast<int>(dynamicResolution->Scale() * 100.0f + 0.5f));
+            else
+                std::snprintf(title, sizeof(title), "Classroom Scene - %.2f ms/frame, input to present %.2f ms", frameMs, latencyMs);
+            glfwSetWindowTitle(window, title);
+        }
+        if (firstFrame)
+        {
+            startup.Mark("first frame");
+            startup.Report();
+            firstFrame = false;
+        }
         
     }
-    PenBody penbody;
-    penbody.~PenBody();
-    PenClip penClip;
-    penClip.~PenClip();
-    PenAccent penAccent;
-    penAccent.~PenAccent();
-    PenPoint penPoint;
-    penPoint.~PenPoint();
-
-    glDeleteVertexArrays(1, &cubeVAO);
-    glDeleteBuffers(1, &cubeVBO);
-    glDeleteVertexArrays(1, &bookVAO);
-    glDeleteBuffers(1, &bookVBO);
-    glDeleteVertexArrays(1, &groundVAO);
-    glDeleteBuffers(1, &groundVBO);
-    glDeleteVertexArrays(1, &blackboardVAO);
-    glDeleteBuffers(1, &blackboardVBO);
-    glDeleteVertexArrays(1, &compassVAO);
-    glDeleteBuffers(1, &compassVBO);
-
-    glDeleteTextures(1, &blueTexture);
-    glDeleteTextures(1, &redTexture);
-    glDeleteTextures(1, &lightgreyTexture);
-    glDeleteTextures(1, &compassTexture);
-    glDeleteTextures(1, &skyboxTexture);
-    glDeleteTextures(1, &blackboardTexture);
-    glDeleteTextures(1, &groundTexture);
-    glDeleteTextures(1, &greyTexture);
-    glDeleteTextures(1, &purpleTexture);
-    glDeleteTextures(1, &metalTexture);
-    glDeleteTextures(1, &deskTexture);
-    glDeleteTextures(1, &ballpointTexture);
-
-
-    glDeleteShader(lightingShader.ID);
-    glDeleteShader(purpleShader.ID);
-    glDeleteShader(greenShader.ID);
-    glDeleteShader(pinkShader.ID);
-
+    delete benchmark;
+    delete occlusion;
+    delete dynamicResolution;
+    delete gpuTimeline;
+    delete uniformRing;
+    delete extraModel;
+    // the GL objects go before the context does
+    penBody.reset();
+    penClip.reset();
+    sphereAccent.reset();
+    penPoint.reset();
+
+    cubeVAO.Reset();
+    cubeVBO.Reset();
+    bookVAO.Reset();
+    skyboxVAO.Reset();
+    bookVBO.Reset();
+    groundVAO.Reset();
+    groundVBO.Reset();
+    blackboardVAO.Reset();
+    blackboardVBO.Reset();
+    compassVAO.Reset();
+    compassVBO.Reset();
+
+    blueTexture.Reset();
+    redTexture.Reset();
+    lightgreyTexture.Reset();
+    compassTexture.Reset();
+    skyboxTexture.Reset();
+    blackboardTexture.Reset();
+    groundTexture.Reset();
+    greyTexture.Reset();
+    purpleTexture.Reset();
+    metalTexture.Reset();
+    deskTexture.Reset();
+    ballpointTexture.Reset();
+
+
+    lightingPermutations.Clear();
+    greenPrograms.Clear();
+    pinkPrograms.Clear();
+    purplePrograms.Clear();
+    whitePrograms.Clear();
+
+    // the pens and shaders manage their own objects and are not in the records
+    GlPools().Shutdown();
+    GpuMemory().ReportLeaks();
 
     glfwTerminate();
-    return 0;
+    return exitCode;
 }
 
 void processInput(GLFWwindow* window)
 {
+    glm::vec3 previousPosition = camera.Position;
+    int previousMode = lightMode;
     if (glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS)
         glfwSetWindowShouldClose(window, true);
     if (glfwGetKey(window, GLFW_KEY_W) == GLFW_PRESS)
@@ -826,40 +1334,23 @@ void processInput(GLFWwindow* window)
         camera.ProcessKeyboard(RIGHT, deltaTime);
    
     if (glfwGetKey(window, GLFW_KEY_1) == GLFW_PRESS)
-    {
-        redLight = true;
-        blueLight = false;
-        purpleLight = false;
-        noLight = false;
-    }
+        lightMode = whiteLights ? 3 : 1;
     if (glfwGetKey(window, GLFW_KEY_2) == GLFW_PRESS)
-    {
-        blueLight = true;
-        redLight = false;
-        purpleLight = false;
-        noLight = false;
-    }
-    if (glfwGetKey(window, GLFW_KEY_3) == GLFW_PRESS)
-    {
-        blueLight = false;
-        redLight = false;
-        purpleLight = true;
-        noLight = false;
-    }
+        lightMode = 2;
+    if (glfwGetKey(window, GLFW_KEY_3) == GLFW_PRESS && !whiteLights)
+        lightMode = 3;
     if (glfwGetKey(window, GLFW_KEY_0) == GLFW_PRESS)
-    {
-        blueLight = false;
-        redLight = false;
-        purpleLight = false;
-        noLight = true;
-    }
+        lightMode = 0;
 
+    if (camera.Position != previousPosition || lightMode != previousMode)
+        sceneDirty = true;
 }
 
 
 void framebuffer_size_callback(GLFWwindow* window, int width, int height)
 {
     glViewport(0, 0, width, height);
+    sceneDirty = true;
 }
 
 void mouse_callback(GLFWwindow* window, double xposIn, double yposIn)
@@ -881,12 +1372,44 @@ void mouse_callback(GLFWwindow* window, double xposIn, double yposIn)
     lastY = ypos;
 
     camera.ProcessMouseMovement(xoffset, yoffset);
+    sceneDirty = true;
 }
 
 
 void scroll_callback(GLFWwindow* window, double xoffset, double yoffset)
 {
     camera.ProcessMouseScroll(static_cast<float>(yoffset));
+    sceneDirty = true;
+}
+
+// the window was uncovered or resized and its contents need drawing again
+void refresh_callback(GLFWwindow* window)
+{
+    sceneDirty = true;
+}
+
+void mouse_button_callback(GLFWwindow* window, int button, int action, int mods)
+{
+    if (button == GLFW_MOUSE_BUTTON_LEFT && action == GLFW_PRESS)
+    {
+        pickRequested = true;
+        sceneDirty = true;
+    }
+}
+
+// one trace per press; the held keys are polled in processInput instead
+void key_callback(GLFWwindow* window, int key, int scancode, int action, int mods)
+{
+    if (key == GLFW_KEY_P && action == GLFW_PRESS)
+    {
+        traceRequested = true;
+        sceneDirty = true;
+    }
+    if (key == GLFW_KEY_M && action == GLFW_PRESS)
+    {
+        memoryReportRequested = true;
+        sceneDirty = true;
+    }
 }
 
 
@@ -895,12 +1418,51 @@ void scroll_callback(GLFWwindow* window, double xoffset, double yoffset)
 
 unsigned int loadTexture(char const* path)
 {
-    unsigned int textureID;
-    glGenTextures(1, &textureID);
+    DecodedTexture texture = decodeTexture(path);
+    return uploadTexture(texture).Release();
+}
+
+// safe to call from worker threads: no GL calls
+DecodedTexture decodeTexture(const char* path, bool streamed)
+{
+    ProfileScope scope("decode texture");
+    DecodedTexture texture = { path, NULL, 0, 0, 0 };
+    texture.data = stbi_load(path, &texture.width, &texture.height, &texture.nrComponents, 0);
+    if (texture.data && streamed)
+        texture.mips = MipChain(texture.data, texture.width, texture.height, texture.nrComponents);
+    return texture;
+}
+
+// the texture streamer's decoder: worker threads, no GL calls
+bool decodeMips(const char* path, MipChain& mips)
+{
+    int width, height, components;
+    unsigned char* data = stbi_load(path, &width, &height, &components, 0);
+    if (!data)
+        return false;
+    mips.Build(data, width, height, components);
+    stbi_image_free(data);
+    return true;
+}
 
-    int width, height, nrComponents;
-    unsigned char* data = stbi_load(path, &width, &height, &nrComponents, 0);
-    if (data)
+// GL thread only; frees the decoded pixels. With a streamer the texture starts with its
+// coarse mips and the streamer takes it from there.
+GlTexture uploadTexture(DecodedTexture& texture, TextureStreamer* streamer)
+{
+    ProfileScope scope("upload texture");
+    GlTexture textureID(GlPools().textures);
+
+    const char* path = texture.path;
+    int width = texture.width, height = texture.height, nrComponents = texture.nrComponents;
+    unsigned char* data = texture.data;
+    texture.data = NULL;
+    if (data && streamer && texture.mips.LevelCount() > 0)
+    {
+        streamer->Add(textureID, texture.mips, path);
+        texture.mips = MipChain();
+        stbi_image_free(data);
+    }
+    else if (data)
     {
         GLenum format;
         if (nrComponents == 1)
@@ -913,6 +1475,9 @@ unsigned int loadTexture(char const* path)
         glBindTexture(GL_TEXTURE_2D, textureID);
         glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format, GL_UNSIGNED_BYTE, data);
         glGenerateMipmap(GL_TEXTURE_2D);
+        const char* formatNames[] = { "", "R8", "", "RGB8", "RGBA8" };
+        GpuMemory().Allocate(GpuResource::Texture, textureID, TextureBytes(width, height, nrComponents, true),
+                             std::to_string(width) + "x" + std::to_string(height) + " " + formatNames[nrComponents] + " mipmapped", path);
 
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
@@ -924,6 +1489,7 @@ unsigned int loadTexture(char const* path)
     else
     {
         std::cout << "Texture failed to load at path: " << path << std::endl;
+        GpuMemory().Allocate(GpuResource::Texture, textureID, 0, "no image", path);
         stbi_image_free(data);
     }
 
@@ -0,0 +1,114 @@
+#ifndef SPECULAR_LIGHTING_H
+#define SPECULAR_LIGHTING_H
+
+#include <glm/glm.hpp>
+
+#include <cmath>
+#include <vector>
+
+// The uniforms of specular.fs, filled once on the CPU. The GL programs get them uploaded
+// at startup and the software rasterizer shades with them through ShadeSpecular, which
+// follows specular.fs line by line.
+struct SpecularLighting
+{
+    struct DirLight
+    {
+        glm::vec3 direction;
+        glm::vec3 ambient;
+        glm::vec3 diffuse;
+        glm::vec3 specular;
+    };
+
+    struct PointLight
+    {
+        glm::vec3 position;
+        float constant;
+        float linear;
+        float quadratic;
+        glm::vec3 ambient;
+        glm::vec3 diffuse;
+        glm::vec3 specular;
+    };
+
+    // position and direction follow the camera
+    struct SpotLight
+    {
+        float cutOff;
+        float outerCutOff;
+        float constant;
+        float linear;
+        float quadratic;
+        glm::vec3 ambient;
+        glm::vec3 diffuse;
+        glm::vec3 specular;
+    };
+
+    float shininess;
+    DirLight dirLight;
+    std::vector<PointLight> pointLights;
+    SpotLight spotLight;
+};
+
+// per-pixel inputs of specular.fs
+struct SpecularSample
+{
+    glm::vec3 fragPos;
+    glm::vec3 normal;
+    glm::vec3 diffuse;      // texture(material.diffuse, TexCoords)
+    glm::vec3 specular;     // texture(material.specular, TexCoords)
+};
+
+inline glm::vec3 SpecularReflect(const glm::vec3& incident, const glm::vec3& normal)
+{
+    return incident - 2.0f * glm::dot(normal, incident) * normal;
+}
+
+// the specular term shared by every light: pow(max(dot(viewDir, reflectDir), 0.0), shininess),
+// skipped where the specular map is black and it could not change the result
+inline float SpecularHighlight(const glm::vec3& lightDir, const glm::vec3& normal, const glm::vec3& viewDir, float shininess, bool specularMap)
+{
+    if (!specularMap)
+        return 0.0f;
+    glm::vec3 reflectDir = SpecularReflect(-lightDir, normal);
+    return std::pow(glm::max(glm::dot(viewDir, reflectDir), 0.0f), shininess);
+}
+
+// main() of specular.fs without the light color tint, which the caller multiplies in
+inline glm::vec3 ShadeSpecular(const SpecularLighting& lighting, const SpecularSample& sample, const glm::vec3& viewPos, const glm::vec3& viewFront)
+{
+    glm::vec3 norm = glm::normalize(sample.normal);
+    glm::vec3 viewDir = glm::normalize(viewPos - sample.fragPos);
+    const bool specularMap = sample.specular.x > 0.0f || sample.specular.y > 0.0f || sample.specular.z > 0.0f;
+
+    // directional light
+    const SpecularLighting::DirLight& dir = lighting.dirLight;
+    glm::vec3 lightDir = glm::normalize(-dir.direction);
+    float diff = glm::max(glm::dot(norm, lightDir), 0.0f);
+    float spec = SpecularHighlight(lightDir, norm, viewDir, lighting.shininess, specularMap);
+    glm::vec3 result = dir.ambient * sample.diffuse + dir.diffuse * diff * sample.diffuse + dir.specular * spec * sample.specular;
+
+    // point lights
+    for (const SpecularLighting::PointLight& light : lighting.pointLights)
+    {
+        lightDir = glm::normalize(light.position - sample.fragPos);
+        diff = glm::max(glm::dot(norm, lightDir), 0.0f);
+        spec = SpecularHighlight(lightDir, norm, viewDir, lighting.shininess, specularMap);
+        float distance = glm::length(light.position - sample.fragPos);
+        float attenuation = 1.0f / (light.constant + light.linear * distance + light.quadratic * (distance * distance));
+        result += (light.ambient * sample.diffuse + light.diffuse * diff * sample.diffuse + light.specular * spec * sample.specular) * attenuation;
+    }
+
+    // spot light at the camera
+    const SpecularLighting::SpotLight& spot = lighting.spotLight;
+    lightDir = glm::normalize(viewPos - sample.fragPos);
+    diff = glm::max(glm::dot(norm, lightDir), 0.0f);
+    spec = SpecularHighlight(lightDir, norm, viewDir, lighting.shininess, specularMap);
+    float distance = glm::length(viewPos - sample.fragPos);
+    float attenuation = 1.0f / (spot.constant + spot.linear * distance + spot.quadratic * (distance * distance));
+    float theta = glm::dot(lightDir, glm::normalize(-viewFront));
+    float epsilon = spot.cutOff - spot.outerCutOff;
+    float intensity = glm::clamp((theta - spot.outerCutOff) / epsilon, 0.0f, 1.0f);
+    result += (spot.ambient * sample.diffuse + spot.diffuse * diff * sample.diffuse + spot.specular * spec * sample.specular) * (attenuation * intensity);
+    return result;
+}
+#endif
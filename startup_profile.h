@@ -0,0 +1,61 @@
+#ifndef STARTUP_PROFILE_H
+#define STARTUP_PROFILE_H
+
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// Splits startup into named stages. Mark() closes the stage that has been running since
+// the previous mark; Report() prints each stage and the total time to that point.
+class StartupProfile
+{
+public:
+    StartupProfile()
+        : start(Clock::now()), last(start)
+    {
+    }
+
+    void Mark(const std::string& stage)
+    {
+        Clock::time_point now = Clock::now();
+        stages.push_back(Stage{ stage, Milliseconds(last, now) });
+        last = now;
+    }
+
+    void Report() const
+    {
+        std::cout << "Startup:" << std::endl;
+        for (const Stage& stage : stages)
+            PrintLine(stage.name.c_str(), stage.milliseconds);
+        PrintLine("total", Milliseconds(start, last));
+    }
+
+private:
+    typedef std::chrono::steady_clock Clock;
+
+    struct Stage
+    {
+        std::string name;
+        double milliseconds;
+    };
+
+    Clock::time_point start;
+    Clock::time_point last;
+    std::vector<Stage> stages;
+
+    // formatted into a buffer so std::cout keeps its own flags
+    static void PrintLine(const char* name, double milliseconds)
+    {
+        char line[128];
+        std::snprintf(line, sizeof(line), "  %-20s%8.1f ms", name, milliseconds);
+        std::cout << line << std::endl;
+    }
+
+    static double Milliseconds(Clock::time_point from, Clock::time_point to)
+    {
+        return std::chrono::duration<double, std::milli>(to - from).count();
+    }
+};
+#endif
@@ -0,0 +1,100 @@
+#ifndef STRESS_BENCHMARK_H
+#define STRESS_BENCHMARK_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#include <psapi.h>
+#ifdef _MSC_VER
+#pragma comment(lib, "psapi.lib")
+#endif
+#else
+#include <unistd.h>
+#endif
+
+// resident memory of this process in bytes (the working set on Windows), 0 if unknown
+inline std::size_t ProcessMemoryBytes()
+{
+#ifdef _WIN32
+    PROCESS_MEMORY_COUNTERS counters;
+    if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+        return counters.WorkingSetSize;
+    return 0;
+#else
+    std::ifstream statm("/proc/self/statm");
+    std::size_t pages = 0, resident = 0;
+    const long pageSize = sysconf(_SC_PAGESIZE);
+    if (pageSize > 0 && statm >> pages >> resident)
+        return resident * static_cast<std::size_t>(pageSize);
+    return 0;
+#endif
+}
+
+// Collects frame times and draw calls for a fixed number of frames after a warm-up, then
+// appends one line to a CSV file. tools/stress_benchmark.cpp runs the scene once per
+// size and gathers the lines into one table.
+class BenchmarkRun
+{
+public:
+    BenchmarkRun(unsigned int frames, unsigned int warmupFrames = 60)
+        : frames(frames), warmupFrames(warmupFrames)
+    {
+        frameMs.reserve(frames);
+    }
+
+    // returns true once enough frames have been recorded
+    bool Frame(double milliseconds, unsigned int drawCalls)
+    {
+        if (warmupFrames > 0)
+        {
+            warmupFrames--;
+            return false;
+        }
+        frameMs.push_back(milliseconds);
+        drawCallSum += drawCalls;
+        peakMemory = std::max(peakMemory, ProcessMemoryBytes());
+        return frameMs.size() >= frames;
+    }
+
+    // columns: rooms, desks, lights, objects, frames, average, 95th percentile, draw calls, memory
+    void Write(const std::string& path, unsigned int rooms, unsigned int desks, unsigned int lights, unsigned int objects) const
+    {
+        if (frameMs.empty())
+            return;
+        std::vector<double> sorted = frameMs;
+        std::sort(sorted.begin(), sorted.end());
+        double sum = 0.0;
+        for (double ms : sorted)
+            sum += ms;
+        double average = sum / sorted.size();
+        double p95 = sorted[std::min(sorted.size() - 1, sorted.size() * 95 / 100)];
+
+        bool exists = std::ifstream(path.c_str()).good();
+        std::ofstream csv(path.c_str(), std::ios::app);
+        if (!exists)
+            csv << "rooms,desks,lights,objects,frames,avg_ms,p95_ms,draw_calls,memory_mb" << std::endl;
+        char line[256];
+        std::snprintf(line, sizeof(line), "%u,%u,%u,%u,%u,%.3f,%.3f,%.1f,%.1f", rooms, desks, lights, objects,
+                      static_cast<unsigned int>(sorted.size()), average, p95, static_cast<double>(drawCallSum) / sorted.size(), peakMemory / (1024.0 * 1024.0));
+        csv << line << std::endl;
+        std::cout << "Benchmark: " << line << std::endl;
+    }
+
+private:
+    unsigned int frames;
+    unsigned int warmupFrames;
+    std::vector<double> frameMs;
+    unsigned long long drawCallSum = 0;
+    std::size_t peakMemory = 0;
+};
+#endif
@@ -0,0 +1,205 @@
+#ifndef STRESS_SCENE_H
+#define STRESS_SCENE_H
+
+#include <glm/glm.hpp>
+
+#include <deque>
+#include <map>
+#include <vector>
+
+#include "portal_visibility.h"
+#include "render_list.h"
+#include "transform_system.h"
+
+// Size of the generated building (--stress ROWS COLUMNS LIGHTS). Desks are placed three
+// by three to a room, the most that fit inside the 7-unit wall cube, so a 6 x 9 grid of
+// desks fills 2 x 3 rooms. The classroom itself stays where it is; the generated rooms
+// continue from it along +x and +z.
+struct StressSceneConfig
+{
+    static const unsigned int DESKS_PER_ROOM_SIDE = 3;
+    // 4 scene lights plus these must fit the fragment uniform limit of GL 3.3 hardware
+    static const unsigned int MAX_LIGHTS = 28;
+
+    unsigned int rows = 0;
+    unsigned int columns = 0;
+    unsigned int lights = 0;
+
+    bool Enabled() const
+    {
+        return rows > 0 && columns > 0;
+    }
+
+    unsigned int RoomRows() const
+    {
+        return (rows + DESKS_PER_ROOM_SIDE - 1) / DESKS_PER_ROOM_SIDE;
+    }
+
+    unsigned int RoomColumns() const
+    {
+        return (columns + DESKS_PER_ROOM_SIDE - 1) / DESKS_PER_ROOM_SIDE;
+    }
+};
+
+// an LOD group made by the generator: one per copied pen
+struct LodGroup
+{
+    TransformSystem::Handle transform;
+    float radius;
+    int level;
+};
+
+// Where everything in the generated building goes. Depends only on the config, so the
+// light positions are known before the scene objects are built.
+class StressLayout
+{
+public:
+    static constexpr float ROOM_SIZE = 7.4f;   // wall cube width plus a gap
+
+    explicit StressLayout(const StressSceneConfig& config)
+        : config(config)
+    {
+    }
+
+    // room 0 is the original classroom
+    unsigned int RoomCount() const
+    {
+        return config.Enabled() ? config.RoomRows() * config.RoomColumns() + 1 : 1;
+    }
+
+    glm::vec3 RoomOffset(unsigned int room) const
+    {
+        if (room == 0)
+            return glm::vec3(0.0f);
+        room--;
+        return glm::vec3((room % config.RoomColumns() + 1) * ROOM_SIZE, 0.0f, (room / config.RoomColumns()) * ROOM_SIZE);
+    }
+
+    unsigned int DeskRoom(unsigned int row, unsigned int column) const
+    {
+        return 1 + (row / DESKS) * config.RoomColumns() + column / DESKS;
+    }
+
+    // offset of desk (row, column) from the original desk
+    glm::vec3 DeskOffset(unsigned int row, unsigned int column) const
+    {
+        const float deskX[DESKS] = { -2.2f, 0.0f, 2.2f };
+        const float deskZ[DESKS] = { -1.2f, 0.6f, 2.4f };
+        return RoomOffset(DeskRoom(row, column)) + glm::vec3(deskX[column % DESKS], 0.0f, deskZ[row % DESKS]);
+    }
+
+    unsigned int LightRoom(unsigned int light) const
+    {
+        return light % RoomCount();
+    }
+
+    // extra lights go round the rooms, the original included, at ceiling height
+    std::vector<glm::vec3> LightPositions() const
+    {
+        const glm::vec3 slots[] = {
+            glm::vec3(-2.0f, 3.0f, -2.0f), glm::vec3(2.0f, 3.0f, 2.0f), glm::vec3(2.0f, 3.0f, -2.0f),
+            glm::vec3(-2.0f, 3.0f, 2.0f), glm::vec3(0.0f, 3.0f, 0.0f),
+        };
+        const unsigned int slotCount = sizeof(slots) / sizeof(slots[0]);
+        std::vector<glm::vec3> positions;
+        for (unsigned int i = 0; i < config.lights; i++)
+        {
+            unsigned int room = LightRoom(i);
+            glm::vec3 slot = slots[(i / RoomCount()) % slotCount];
+            positions.push_back(RoomOffset(room) + slot + glm::vec3(0.0f, 0.0f, -0.2f));
+        }
+        return positions;
+    }
+
+    // One cell per room, added in room order so cell and room numbers match, spanning the
+    // wall cube's height and the room spacing across. Rooms side by side along x share a
+    // door, rooms one behind the other along z a window; the original classroom has a door
+    // into the first generated room.
+    void AddCells(PortalVisibility& cells, const glm::vec3& wallCenter, float wallSize) const
+    {
+        const glm::vec3 half(ROOM_SIZE * 0.5f, wallSize * 0.5f, ROOM_SIZE * 0.5f);
+        for (unsigned int room = 0; room < RoomCount(); room++)
+        {
+            glm::vec3 center = RoomOffset(room) + wallCenter;
+            cells.AddCell(center - half, center + half);
+        }
+        const float floor = wallCenter.y - half.y;
+        for (unsigned int room = 0; room < RoomCount(); room++)
+        {
+            glm::vec3 center = RoomOffset(room) + wallCenter;
+            int column = room == 0 ? -1 : static_cast<int>((room - 1) % config.RoomColumns());
+            int row = room == 0 ? 0 : static_cast<int>((room - 1) / config.RoomColumns());
+            if (column + 1 < static_cast<int>(config.RoomColumns()) && config.Enabled())
+            {
+                // door in the wall towards +x
+                float x = center.x + half.x;
+                const glm::vec3 door[4] = {
+                    glm::vec3(x, floor, center.z - 0.8f), glm::vec3(x, floor, center.z + 0.8f),
+                    glm::vec3(x, floor + 4.5f, center.z + 0.8f), glm::vec3(x, floor + 4.5f, center.z - 0.8f),
+                };
+                cells.AddPortal(static_cast<int>(room), static_cast<int>(room) + 1, door);
+            }
+            if (room > 0 && row + 1 < static_cast<int>(config.RoomRows()))
+            {
+                // window in the wall towards +z
+                float z = center.z + half.z;
+                const glm::vec3 window[4] = {
+                    glm::vec3(center.x - 1.5f, floor + 3.0f, z), glm::vec3(center.x + 1.5f, floor + 3.0f, z),
+                    glm::vec3(center.x + 1.5f, floor + 5.0f, z), glm::vec3(center.x - 1.5f, floor + 5.0f, z),
+                };
+                cells.AddPortal(static_cast<int>(room), static_cast<int>(room + config.RoomColumns()), window);
+            }
+        }
+    }
+
+private:
+    static const unsigned int DESKS = StressSceneConfig::DESKS_PER_ROOM_SIDE;
+    StressSceneConfig config;
+};
+
+// Copies scene objects under a new root transform. Transforms are copied with their
+// local values, and parents are copied along with them (the ground stays attached to its
+// blackboard), each only once; the topmost copies hang off root. Objects drawn
+// with a fixed model matrix (the pens) are placed at root instead. Copies of objects in
+// an LOD group get a group of their own, appended to lodGroups. Every copy is put in cell.
+inline void CloneObjects(const std::vector<SceneObject>& templates, TransformSystem& transforms, TransformSystem::Handle root,
+                         std::vector<SceneObject>& objects, std::deque<LodGroup>& lodGroups, float lodRadius, int cell)
+{
+    std::map<TransformSystem::Handle, TransformSystem::Handle> copied;
+    std::map<const int*, int*> groups;
+    for (const SceneObject& source : templates)
+    {
+        SceneObject copy = source;
+        copy.fixedModel = NULL;
+        copy.cell = cell;
+        if (source.fixedModel)
+        {
+            copy.transform = transforms.Add(glm::vec3(0.0f), glm::quat(1.0f, 0.0f, 0.0f, 0.0f), glm::vec3(1.0f), root);
+        }
+        else
+        {
+            // parents first, so every parent is added before its children
+            std::vector<TransformSystem::Handle> chain;
+            for (int handle = source.transform; handle != TransformSystem::NO_PARENT && !copied.count(handle); handle = transforms.Parent(handle))
+                chain.push_back(handle);
+            for (auto it = chain.rbegin(); it != chain.rend(); ++it)
+            {
+                int parent = transforms.Parent(*it);
+                int newParent = parent == TransformSystem::NO_PARENT ? static_cast<int>(root) : static_cast<int>(copied[parent]);
+                copied[*it] = transforms.Add(transforms.Translation(*it), transforms.Rotation(*it), transforms.Scale(*it), newParent);
+            }
+            copy.transform = copied[source.transform];
+        }
+        if (source.lodLevel)
+        {
+            if (!groups.count(source.lodLevel))
+            {
+                lodGroups.push_back({ copy.transform, lodRadius, 0 });
+                groups[source.lodLevel] = &lodGroups.back().level;
+            }
+            copy.lodLevel = groups[source.lodLevel];
+        }
+        objects.push_back(copy);
+    }
+}
+#endif
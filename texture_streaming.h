@@ -0,0 +1,519 @@
+#ifndef TEXTURE_STREAMING_H
+#define TEXTURE_STREAMING_H
+
+#include <glad/glad.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "frame_profiler.h"
+#include "gpu_memory.h"
+#include "job_system.h"
+
+// An image and its box-filtered mip levels in one block of memory, built on the CPU so a
+// worker thread can do it.
+class MipChain
+{
+public:
+    struct Level
+    {
+        int width;
+        int height;
+        std::size_t offset;
+    };
+
+    MipChain() = default;
+
+    MipChain(const unsigned char* pixels, int width, int height, int components)
+    {
+        Build(pixels, width, height, components);
+    }
+
+    // builds the chain of another image, reusing the storage of the last one
+    void Build(const unsigned char* pixels, int width, int height, int components)
+    {
+        ProfileScope scope("build mips");
+        this->components = components;
+        levels.clear();
+        std::size_t bytes = 0;
+        for (int w = width, h = height;; w = w > 1 ? w / 2 : 1, h = h > 1 ? h / 2 : 1)
+        {
+            levels.push_back({ w, h, bytes });
+            bytes += static_cast<std::size_t>(w) * h * components;
+            if (w == 1 && h == 1)
+                break;
+        }
+        texels.resize(bytes);
+        std::memcpy(texels.data(), pixels, static_cast<std::size_t>(width) * height * components);
+        for (unsigned int i = 1; i < levels.size(); i++)
+            Downsample(levels[i - 1], levels[i]);
+    }
+
+    int Components() const
+    {
+        return components;
+    }
+
+    int LevelCount() const
+    {
+        return static_cast<int>(levels.size());
+    }
+
+    const Level& GetLevel(int level) const
+    {
+        return levels[level];
+    }
+
+    const std::vector<Level>& Levels() const
+    {
+        return levels;
+    }
+
+    const unsigned char* Texels(int level) const
+    {
+        return texels.data() + levels[level].offset;
+    }
+
+    std::size_t TotalBytes() const
+    {
+        return texels.size();
+    }
+
+private:
+    std::vector<Level> levels;
+    std::vector<unsigned char> texels;
+    int components = 0;
+
+    // each texel averages a 2x2 block of the level above; the last row or column of an
+    // odd-sized level is folded into its neighbour's block
+    void Downsample(const Level& source, const Level& target)
+    {
+        const unsigned char* from = texels.data() + source.offset;
+        unsigned char* to = texels.data() + target.offset;
+        for (int y = 0; y < target.height; y++)
+        {
+            int y0 = std::min(y * 2, source.height - 1), y1 = std::min(y * 2 + 1, source.height - 1);
+            for (int x = 0; x < target.width; x++)
+            {
+                int x0 = std::min(x * 2, source.width - 1), x1 = std::min(x * 2 + 1, source.width - 1);
+                for (int c = 0; c < components; c++)
+                {
+                    int sum = from[(y0 * source.width + x0) * components + c] + from[(y0 * source.width + x1) * components + c] +
+                              from[(y1 * source.width + x0) * components + c] + from[(y1 * source.width + x1) * components + c];
+                    to[(y * target.width + x) * components + c] = static_cast<unsigned char>((sum + 2) / 4);
+                }
+            }
+        }
+    }
+};
+
+// Keeps only the mip levels the scene needs on the GPU. A texture starts with its levels of
+// START_SIZE texels and smaller, which stay for good. While drawing, the command-list
+// workers report how many pixels each textured object covers on screen; once a frame the
+// GL thread works out which finer levels that coverage calls for. When they would not fit
+// in the budget, textures give up their finer levels, least recently used first: textures
+// not drawn lately down to their starting levels, textures drawn this frame only down to
+// what they asked for.
+//
+// No CPU copy of the finer levels is kept. A texture that needs them is decoded again from
+// its file on a worker, into one of LOAD_SLOTS buffers that are reused from load to load,
+// and only its missing levels are uploaded. System memory for streaming is therefore at
+// most LOAD_SLOTS of the largest texture's chain, however many textures there are.
+//
+// Each level keeps its index in the full chain; GL_TEXTURE_BASE_LEVEL points at the finest
+// resident one and levels above it are specified empty. The texture keeps its name, so the
+// draws that use it need not change.
+class TextureStreamer
+{
+public:
+    static const int START_SIZE = 64;
+    static const int LOAD_SLOTS = 2;
+    static const unsigned int RETRY_FRAMES = 60;   // before a texture that did not fit loads again
+
+    // worker threads: decodes the image at path into mips, reusing their storage
+    typedef bool (*Decoder)(const char* path, MipChain& mips);
+
+    // budgetBytes of 0 never evicts
+    TextureStreamer(JobSystem& jobs, Decoder decode, std::size_t budgetBytes)
+        : jobs(jobs), decode(decode), budget(budgetBytes)
+    {
+        for (LoadSlot& slot : slots)
+            slot.streamer = this;
+    }
+
+    ~TextureStreamer()
+    {
+        jobs.Wait(loadsInFlight);
+    }
+
+    TextureStreamer(const TextureStreamer&) = delete;
+    TextureStreamer& operator=(const TextureStreamer&) = delete;
+
+    // bytes uploaded per frame before the rest of the requests wait for the next frame;
+    // 0 uploads everything at once. The first upload of a frame always goes ahead.
+    void SetUploadLimit(std::size_t bytesPerFrame)
+    {
+        uploadLimit = bytesPerFrame;
+    }
+
+    // Update() waits for the loads it starts instead of picking them up in a later frame,
+    // so what is drawn does not depend on how fast the workers decode
+    void SetBlocking(bool blocking)
+    {
+        this->blocking = blocking;
+    }
+
+    // GL thread, at load time: streams texture, whose image is at path and already decoded
+    // into mips. Only the coarse levels are uploaded; the caller may free mips afterwards.
+    // Register every texture before the first frame; Request() does not lock.
+    void Add(unsigned int texture, const MipChain& mips, const char* path)
+    {
+        std::unique_ptr<Entry> entry(new Entry());
+        entry->name = texture;
+        entry->path = path;
+        entry->levels = mips.Levels();
+        entry->totalBytes = mips.TotalBytes();
+        entry->components = mips.Components();
+        entry->startLevel = 0;
+        while (entry->startLevel + 1 < mips.LevelCount() && Largest(mips.GetLevel(entry->startLevel)) > START_SIZE)
+            entry->startLevel++;
+        entry->resident = mips.LevelCount();
+
+        const char* formatNames[] = { "", "R8", "", "RGB8", "RGBA8" };
+        char format[64];
+        std::snprintf(format, sizeof(format), "%dx%d %s streamed", mips.GetLevel(0).width, mips.GetLevel(0).height, formatNames[mips.Components()]);
+        GpuMemory().Allocate(GpuResource::Texture, texture, 0, format, path);
+
+        glBindTexture(GL_TEXTURE_2D, texture);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, mips.LevelCount() - 1);
+        SetResident(*entry, entry->startLevel, &mips);
+
+        byName[texture] = entry.get();
+        byUrgency.push_back(entry.get());
+        byLastUse.push_back(entry.get());
+        entries.push_back(std::move(entry));
+    }
+
+    // Any thread, while the frame is built: texture is drawn covering about screenPixels
+    // pixels across. Unknown textures are ignored.
+    void Request(unsigned int texture, float screenPixels)
+    {
+        auto it = byName.find(texture);
+        if (it == byName.end())
+            return;
+        Entry& entry = *it->second;
+        int level = 0;
+        float ratio = Largest(entry.levels[0]) / std::max(screenPixels, 1.0f);
+        // one level finer than the coverage alone asks for, to allow for surfaces seen at
+        // an angle and textures repeated across them
+        if (ratio > 2.0f)
+            level = std::min(static_cast<int>(std::log2(ratio)) - 1, static_cast<int>(entry.levels.size()) - 1);
+        int wanted = entry.wanted.load(std::memory_order_relaxed);
+        while (level < wanted && !entry.wanted.compare_exchange_weak(wanted, level, std::memory_order_relaxed))
+        {
+        }
+    }
+
+    // GL thread, once a frame after the requests are in: starts loads, uploads what has
+    // been decoded and evicts
+    void Update()
+    {
+        frame++;
+        frameUploadBytes = 0;
+        for (auto& entry : entries)
+        {
+            entry->frameWanted = entry->wanted.exchange(NOT_REQUESTED, std::memory_order_relaxed);
+            if (entry->frameWanted != NOT_REQUESTED)
+                entry->lastUsed = frame;
+        }
+        std::sort(byLastUse.begin(), byLastUse.end(), [](const Entry* a, const Entry* b) { return a->lastUsed < b->lastUsed; });
+        // in case textures were added past the budget
+        MakeRoom(0, NULL);
+
+        std::sort(byUrgency.begin(), byUrgency.end(), [](const Entry* a, const Entry* b) { return Shortfall(*a) > Shortfall(*b); });
+        for (Entry* entry : byUrgency)
+        {
+            if (Shortfall(*entry) <= 0)
+                break;
+            if (!entry->load && !entry->failed && frame >= entry->retryFrame)
+                StartLoad(*entry);
+        }
+        if (blocking)
+            jobs.Wait(loadsInFlight);
+
+        for (Entry* entry : byUrgency)
+        {
+            if (Shortfall(*entry) <= 0)
+                break;
+            LoadSlot* slot = entry->load;
+            if (!slot || slot->state.load(std::memory_order_acquire) == LoadSlot::DECODING)
+                continue;
+            if (slot->state.load(std::memory_order_acquire) == LoadSlot::FAILED)
+            {
+                std::cout << "WARNING::TEXTURE_STREAMING:: cannot decode " << entry->path << " again; it stays at its coarse levels" << std::endl;
+                entry->failed = true;
+                FreeSlot(*slot);
+                continue;
+            }
+            if (uploadLimit > 0 && frameUploadBytes >= uploadLimit)
+                continue;
+            // settle for a coarser level when the finest one will not fit even after evicting
+            const std::size_t available = budget + Reclaimable(entry);
+            int target = entry->frameWanted;
+            while (target < entry->resident && budget > 0 && residentBytes - Bytes(*entry, entry->resident) + Bytes(*entry, target) > available)
+                target++;
+            if (target < entry->resident && MakeRoom(Bytes(*entry, target) - Bytes(*entry, entry->resident), entry))
+                SetResident(*entry, target, &slot->mips);
+            if (entry->resident > entry->frameWanted)
+                entry->retryFrame = frame + RETRY_FRAMES;
+            FreeSlot(*slot);
+        }
+
+        // a decoded image nobody asks for any more is dropped
+        for (LoadSlot& slot : slots)
+        {
+            if (slot.entry && slot.state.load(std::memory_order_acquire) != LoadSlot::DECODING && slot.entry->lastUsed != frame)
+                FreeSlot(slot);
+        }
+    }
+
+    // GL thread, after Update(): whether a later Update() still has work, a load to wait
+    // for or upload, or a level to fetch. Failed textures and ones waiting to retry do not count.
+    bool Pending() const
+    {
+        if (loadsInFlight.load() > 0)
+            return true;
+        for (const auto& entry : entries)
+        {
+            if (entry->load || (Shortfall(*entry) > 0 && !entry->failed && frame >= entry->retryFrame))
+                return true;
+        }
+        return false;
+    }
+
+    std::size_t ResidentBytes() const
+    {
+        return residentBytes;
+    }
+
+    void Report() const
+    {
+        std::cout << "Texture streaming: " << Megabytes(residentBytes) << " MB resident";
+        if (budget > 0)
+            std::cout << " of a " << Megabytes(budget) << " MB budget";
+        std::cout << ", " << loads << " loads, " << Megabytes(uploadedBytes) << " MB uploaded, " << evictions << " evictions" << std::endl;
+        for (const auto& entry : entries)
+        {
+            const MipChain::Level& top = entry->levels[0];
+            const MipChain::Level& level = entry->levels[entry->resident];
+            char line[256];
+            std::snprintf(line, sizeof(line), "  %-40s %5dx%-5d of %5dx%-5d %8.2f MB", entry->path.c_str(), level.width, level.height, top.width, top.height,
+                          Megabytes(Bytes(*entry, entry->resident)));
+            std::cout << line << std::endl;
+        }
+    }
+
+private:
+    static const int NOT_REQUESTED = 1 << 30;
+
+    struct Entry;
+
+    // a buffer a worker decodes one texture into
+    struct LoadSlot
+    {
+        enum State
+        {
+            DECODING,
+            READY,
+            FAILED,
+        };
+
+        TextureStreamer* streamer = NULL;
+        Entry* entry = NULL;    // NULL while the slot is free
+        MipChain mips;
+        std::atomic<int> state{ READY };
+    };
+
+    struct Entry
+    {
+        unsigned int name = 0;
+        std::string path;
+        std::vector<MipChain::Level> levels;
+        std::size_t totalBytes = 0;
+        int components = 0;
+        int startLevel = 0;     // never evicted past this
+        int resident = 0;       // finest level on the GPU
+        std::atomic<int> wanted{ NOT_REQUESTED };    // finest level asked for this frame
+        int frameWanted = NOT_REQUESTED;
+        unsigned int lastUsed = 0;
+        unsigned int retryFrame = 0;
+        LoadSlot* load = NULL;
+        bool failed = false;
+    };
+
+    JobSystem& jobs;
+    Decoder decode;
+    std::vector<std::unique_ptr<Entry>> entries;
+    std::unordered_map<unsigned int, Entry*> byName;
+    std::vector<Entry*> byUrgency;
+    std::vector<Entry*> byLastUse;     // sorted once a frame, least recently used first
+    LoadSlot slots[LOAD_SLOTS];
+    std::atomic<int> loadsInFlight{ 0 };
+    std::size_t budget;
+    std::size_t uploadLimit = 8 * 1024 * 1024;
+    std::size_t frameUploadBytes = 0;
+    std::size_t residentBytes = 0;
+    std::size_t uploadedBytes = 0;
+    bool blocking = false;
+    unsigned int frame = 0;
+    unsigned int loads = 0;
+    unsigned int evictions = 0;
+
+    static int Largest(const MipChain::Level& level)
+    {
+        return std::max(level.width, level.height);
+    }
+
+    // bytes of the levels from firstLevel down to 1x1
+    static std::size_t Bytes(const Entry& entry, int firstLevel)
+    {
+        if (firstLevel >= static_cast<int>(entry.levels.size()))
+            return 0;
+        return entry.totalBytes - entry.levels[firstLevel].offset;
+    }
+
+    // how many levels finer than what is resident this frame asked for
+    static int Shortfall(const Entry& entry)
+    {
+        return entry.frameWanted == NOT_REQUESTED ? 0 : entry.resident - entry.frameWanted;
+    }
+
+    void StartLoad(Entry& entry)
+    {
+        for (LoadSlot& slot : slots)
+        {
+            if (slot.entry)
+                continue;
+            slot.entry = &entry;
+            slot.state.store(LoadSlot::DECODING, std::memory_order_relaxed);
+            entry.load = &slot;
+            loads++;
+            loadsInFlight++;
+            LoadSlot* target = &slot;
+            jobs.Submit([target]() { target->streamer->Decode(*target); });
+            return;
+        }
+    }
+
+    // worker thread; the entry's fields read here do not change after Add()
+    void Decode(LoadSlot& slot)
+    {
+        ProfileScope scope("stream texture decode");
+        const Entry& entry = *slot.entry;
+        bool decoded = decode(entry.path.c_str(), slot.mips) && slot.mips.Components() == entry.components && slot.mips.LevelCount() == static_cast<int>(entry.levels.size()) &&
+                       slot.mips.GetLevel(0).width == entry.levels[0].width && slot.mips.GetLevel(0).height == entry.levels[0].height;
+        slot.state.store(decoded ? LoadSlot::READY : LoadSlot::FAILED, std::memory_order_release);
+        loadsInFlight--;
+    }
+
+    // the slot keeps its buffer for the next load
+    static void FreeSlot(LoadSlot& slot)
+    {
+        slot.entry->load = NULL;
+        slot.entry = NULL;
+    }
+
+    // the lowest level a texture may be evicted to: its starting level, or while it is
+    // drawn, what this frame asked for
+    int Coarsest(const Entry& entry) const
+    {
+        return entry.lastUsed == frame ? std::min(entry.frameWanted, entry.startLevel) : entry.startLevel;
+    }
+
+    // bytes MakeRoom() could free for keep
+    std::size_t Reclaimable(const Entry* keep) const
+    {
+        std::size_t bytes = 0;
+        for (const auto& entry : entries)
+        {
+            if (entry.get() != keep && entry->resident < Coarsest(*entry))
+                bytes += Bytes(*entry, entry->resident) - Bytes(*entry, Coarsest(*entry));
+        }
+        return bytes;
+    }
+
+    // Drops levels, least recently used textures first, until bytes more fit in the budget.
+    // keep is the texture making room and is left alone. Returns false if they do not fit.
+    bool MakeRoom(std::size_t bytes, const Entry* keep)
+    {
+        if (budget == 0 || residentBytes + bytes <= budget)
+            return true;
+        for (Entry* entry : byLastUse)
+        {
+            if (entry == keep)
+                continue;
+            int coarsest = Coarsest(*entry);
+            if (entry->resident >= coarsest)
+                continue;
+            int target = entry->resident + 1;
+            while (target < coarsest && residentBytes - (Bytes(*entry, entry->resident) - Bytes(*entry, target)) + bytes > budget)
+                target++;
+            SetResident(*entry, target, NULL);
+            evictions++;
+            if (residentBytes + bytes <= budget)
+                return true;
+        }
+        return false;
+    }
+
+    // Makes level the finest resident one. Going finer uploads the missing levels from
+    // source, a chain of the whole image; going coarser specifies the dropped levels empty,
+    // which frees them and uploads nothing.
+    void SetResident(Entry& entry, int level, const MipChain* source)
+    {
+        ProfileScope scope("stream texture");
+        const GLenum formats[] = { 0, GL_RED, 0, GL_RGB, GL_RGBA };
+        const GLenum format = formats[entry.components];
+        glBindTexture(GL_TEXTURE_2D, entry.name);
+        if (level < entry.resident)
+        {
+            glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+            for (int i = level; i < entry.resident; i++)
+            {
+                const MipChain::Level& size = source->GetLevel(i);
+                glTexImage2D(GL_TEXTURE_2D, i, format, size.width, size.height, 0, format, GL_UNSIGNED_BYTE, source->Texels(i));
+            }
+            glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+            frameUploadBytes += Bytes(entry, level) - Bytes(entry, entry.resident);
+            uploadedBytes += Bytes(entry, level) - Bytes(entry, entry.resident);
+        }
+        else
+        {
+            for (int i = entry.resident; i < level; i++)
+                glTexImage2D(GL_TEXTURE_2D, i, format, 0, 0, 0, format, GL_UNSIGNED_BYTE, NULL);
+        }
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, level);
+
+        residentBytes = residentBytes - Bytes(entry, entry.resident) + Bytes(entry, level);
+        entry.resident = level;
+        GpuMemory().Resize(GpuResource::Texture, entry.name, Bytes(entry, level));
+    }
+
+    static double Megabytes(std::size_t bytes)
+    {
+        return bytes / (1024.0 * 1024.0);
+    }
+};
+#endif
@@ -0,0 +1,297 @@
+// Converts a Wavefront .obj (with its .mtl, if any) into the .mesh format read by
+// BinaryModel. Faces are triangulated, identical position/texcoord/normal corners are
+// merged into one vertex, and each run of faces with the same material becomes a
+// submesh. Corners without a normal get their face's normal.
+//
+//   mesh_convert input.obj output.mesh
+//
+// Build: g++ -std=c++14 -O2 -I.. mesh_convert.cpp -o mesh_convert
+// (or add it as a console project next to the scene in Visual Studio)
+
+#include "../mesh_file.h"
+
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <climits>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+struct ObjMaterial
+{
+    std::string diffuse;
+    std::string specular;
+    float shininess = 32.0f;
+};
+
+static std::string DirectoryOf(const std::string& path)
+{
+    return path.substr(0, path.find_last_of("/\\") + 1);
+}
+
+static void ReadMaterials(const std::string& path, std::map<std::string, ObjMaterial>& materials)
+{
+    std::ifstream file(path.c_str());
+    if (!file)
+    {
+        std::cout << "warning: cannot open material library " << path << std::endl;
+        return;
+    }
+    std::string line;
+    ObjMaterial* current = NULL;
+    while (std::getline(file, line))
+    {
+        std::istringstream stream(line);
+        std::string keyword;
+        stream >> keyword;
+        if (keyword == "newmtl")
+        {
+            std::string name;
+            stream >> name;
+            current = &materials[name];
+        }
+        else if (current && keyword == "map_Kd")
+            stream >> current->diffuse;
+        else if (current && keyword == "map_Ks")
+            stream >> current->specular;
+        else if (current && keyword == "Ns")
+            stream >> current->shininess;
+    }
+}
+
+// obj indices are 1-based, or negative to count back from the latest element; an empty
+// token gives -1. Returns false if the token is not a number.
+static bool ResolveIndex(const std::string& token, std::size_t count, int& index)
+{
+    index = -1;
+    if (token.empty())
+        return true;
+    char* end = NULL;
+    errno = 0;
+    long value = std::strtol(token.c_str(), &end, 10);
+    if (*end != '\0' || end == token.c_str() || errno == ERANGE || value < INT_MIN + 1 || value > INT_MAX)
+        return false;
+    index = value < 0 ? static_cast<int>(count) + static_cast<int>(value) : static_cast<int>(value) - 1;
+    return true;
+}
+
+int main(int argc, char** argv)
+{
+    if (argc != 3)
+    {
+        std::cout << "usage: mesh_convert input.obj output.mesh" << std::endl;
+        return 1;
+    }
+    std::ifstream input(argv[1]);
+    if (!input)
+    {
+        std::cout << "cannot open " << argv[1] << std::endl;
+        return 1;
+    }
+
+    std::vector<std::array<float, 3>> positions;
+    std::vector<std::array<float, 3>> normals;
+    std::vector<std::array<float, 2>> texCoords;
+    std::map<std::string, ObjMaterial> objMaterials;
+    std::vector<std::string> materialNames;
+
+    std::vector<MeshFileVertex> vertices;
+    std::vector<std::uint32_t> indices;
+    std::vector<MeshFileSubmesh> submeshes;
+    std::map<std::array<int, 3>, std::uint32_t> vertexIndex;
+    std::uint32_t currentMaterial = 0;
+    int faceCount = 0;
+
+    std::string line;
+    while (std::getline(input, line))
+    {
+        std::istringstream stream(line);
+        std::string keyword;
+        stream >> keyword;
+        if (keyword == "v")
+        {
+            std::array<float, 3> p = {};
+            stream >> p[0] >> p[1] >> p[2];
+            positions.push_back(p);
+        }
+        else if (keyword == "vn")
+        {
+            std::array<float, 3> n = {};
+            stream >> n[0] >> n[1] >> n[2];
+            normals.push_back(n);
+        }
+        else if (keyword == "vt")
+        {
+            std::array<float, 2> t = {};
+            stream >> t[0] >> t[1];
+            texCoords.push_back(t);
+        }
+        else if (keyword == "mtllib")
+        {
+            std::string library;
+            stream >> library;
+            ReadMaterials(DirectoryOf(argv[1]) + library, objMaterials);
+        }
+        else if (keyword == "usemtl")
+        {
+            std::string name;
+            stream >> name;
+            auto found = std::find(materialNames.begin(), materialNames.end(), name);
+            currentMaterial = static_cast<std::uint32_t>(found - materialNames.begin());
+            if (found == materialNames.end())
+                materialNames.push_back(name);
+        }
+        else if (keyword == "f")
+        {
+            // corner = position/texcoord/normal, the last two optional
+            std::vector<std::array<int, 3>> corners;
+            std::string token;
+            while (stream >> token)
+            {
+                std::string parts[3];
+                std::size_t part = 0;
+                for (char c : token)
+                {
+                    if (c == '/')
+                        part++;
+                    else if (part < 3)
+                        parts[part] += c;
+                }
+                std::array<int, 3> corner;
+                if (!ResolveIndex(parts[0], positions.size(), corner[0]) || !ResolveIndex(parts[1], texCoords.size(), corner[1]) ||
+                    !ResolveIndex(parts[2], normals.size(), corner[2]))
+                {
+                    std::cout << "invalid face: " << line << std::endl;
+                    return 1;
+                }
+                corners.push_back(corner);
+            }
+            if (corners.size() < 3)
+                continue;
+            for (const std::array<int, 3>& corner : corners)
+            {
+                if (corner[0] < 0 || corner[0] >= static_cast<int>(positions.size()))
+                {
+                    std::cout << "invalid face: " << line << std::endl;
+                    return 1;
+                }
+            }
+
+            // face normal, for corners that do not name one
+            const std::array<float, 3>& a = positions[corners[0][0]];
+            const std::array<float, 3>& b = positions[corners[1][0]];
+            const std::array<float, 3>& c = positions[corners[2][0]];
+            float e1[3] = { b[0] - a[0], b[1] - a[1], b[2] - a[2] };
+            float e2[3] = { c[0] - a[0], c[1] - a[1], c[2] - a[2] };
+            float faceNormal[3] = { e1[1] * e2[2] - e1[2] * e2[1], e1[2] * e2[0] - e1[0] * e2[2], e1[0] * e2[1] - e1[1] * e2[0] };
+            float length = std::sqrt(faceNormal[0] * faceNormal[0] + faceNormal[1] * faceNormal[1] + faceNormal[2] * faceNormal[2]);
+            for (float& component : faceNormal)
+                component = length > 0.0f ? component / length : 0.0f;
+
+            if (submeshes.empty() || submeshes.back().material != currentMaterial)
+                submeshes.push_back({ static_cast<std::uint32_t>(indices.size()), 0, currentMaterial, 0 });
+
+            std::vector<std::uint32_t> faceIndices;
+            for (const std::array<int, 3>& corner : corners)
+            {
+                // corners using the face normal are never shared with other faces
+                std::array<int, 3> key = { corner[0], corner[1], corner[2] >= 0 ? corner[2] : -1 - faceCount };
+                auto found = vertexIndex.find(key);
+                if (found != vertexIndex.end())
+                {
+                    faceIndices.push_back(found->second);
+                    continue;
+                }
+                MeshFileVertex vertex = {};
+                std::copy(positions[corner[0]].begin(), positions[corner[0]].end(), vertex.position);
+                if (corner[1] >= 0 && corner[1] < static_cast<int>(texCoords.size()))
+                    std::copy(texCoords[corner[1]].begin(), texCoords[corner[1]].end(), vertex.texCoords);
+                if (corner[2] >= 0 && corner[2] < static_cast<int>(normals.size()))
+                    std::copy(normals[corner[2]].begin(), normals[corner[2]].end(), vertex.normal);
+                else
+                    std::copy(faceNormal, faceNormal + 3, vertex.normal);
+                std::uint32_t index = static_cast<std::uint32_t>(vertices.size());
+                vertices.push_back(vertex);
+                vertexIndex[key] = index;
+                faceIndices.push_back(index);
+            }
+            for (std::size_t i = 1; i + 1 < faceIndices.size(); i++)
+            {
+                indices.push_back(faceIndices[0]);
+                indices.push_back(faceIndices[i]);
+                indices.push_back(faceIndices[i + 1]);
+                submeshes.back().indexCount += 3;
+            }
+            faceCount++;
+        }
+    }
+    if (materialNames.empty())
+        materialNames.push_back("");
+
+    std::vector<MeshFileMaterial> materials;
+    for (const std::string& name : materialNames)
+    {
+        MeshFileMaterial material = {};
+        material.shininess = 32.0f;
+        auto found = objMaterials.find(name);
+        if (found != objMaterials.end())
+        {
+            if (found->second.diffuse.size() >= sizeof(material.diffuse) || found->second.specular.size() >= sizeof(material.specular))
+                std::cout << "warning: texture path of material " << name << " is too long and was cut" << std::endl;
+            std::strncpy(material.diffuse, found->second.diffuse.c_str(), sizeof(material.diffuse) - 1);
+            std::strncpy(material.specular, found->second.specular.c_str(), sizeof(material.specular) - 1);
+            material.shininess = found->second.shininess;
+        }
+        materials.push_back(material);
+    }
+
+    MeshFileHeader header = {};
+    std::memcpy(header.magic, MESH_FILE_MAGIC, 4);
+    header.version = MESH_FILE_VERSION;
+    header.vertexCount = static_cast<std::uint32_t>(vertices.size());
+    header.indexCount = static_cast<std::uint32_t>(indices.size());
+    header.submeshCount = static_cast<std::uint32_t>(submeshes.size());
+    header.materialCount = static_cast<std::uint32_t>(materials.size());
+    header.vertexOffset = MeshFileAlign(sizeof(MeshFileHeader));
+    header.indexOffset = MeshFileAlign(header.vertexOffset + vertices.size() * sizeof(MeshFileVertex));
+    header.submeshOffset = MeshFileAlign(header.indexOffset + indices.size() * sizeof(std::uint32_t));
+    header.materialOffset = MeshFileAlign(header.submeshOffset + submeshes.size() * sizeof(MeshFileSubmesh));
+    for (int axis = 0; axis < 3; axis++)
+    {
+        header.boundsMin[axis] = vertices.empty() ? 0.0f : vertices[0].position[axis];
+        header.boundsMax[axis] = header.boundsMin[axis];
+        for (const MeshFileVertex& vertex : vertices)
+        {
+            header.boundsMin[axis] = std::min(header.boundsMin[axis], vertex.position[axis]);
+            header.boundsMax[axis] = std::max(header.boundsMax[axis], vertex.position[axis]);
+        }
+    }
+
+    std::ofstream output(argv[2], std::ios::binary | std::ios::trunc);
+    if (!output)
+    {
+        std::cout << "cannot write " << argv[2] << std::endl;
+        return 1;
+    }
+    auto writeAt = [&output](std::uint64_t offset, const void* data, std::size_t size) {
+        static const char padding[MESH_FILE_ALIGNMENT] = {};
+        std::uint64_t position = static_cast<std::uint64_t>(output.tellp());
+        output.write(padding, static_cast<std::streamsize>(offset - position));
+        output.write(static_cast<const char*>(data), static_cast<std::streamsize>(size));
+    };
+    output.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    writeAt(header.vertexOffset, vertices.data(), vertices.size() * sizeof(MeshFileVertex));
+    writeAt(header.indexOffset, indices.data(), indices.size() * sizeof(std::uint32_t));
+    writeAt(header.submeshOffset, submeshes.data(), submeshes.size() * sizeof(MeshFileSubmesh));
+    writeAt(header.materialOffset, materials.data(), materials.size() * sizeof(MeshFileMaterial));
+
+    std::cout << argv[2] << ": " << vertices.size() << " vertices, " << indices.size() / 3 << " triangles, "
+              << submeshes.size() << " submeshes, " << materials.size() << " materials" << std::endl;
+    return 0;
+}
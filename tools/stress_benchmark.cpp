@@ -0,0 +1,51 @@
+// Runs the scene over a sweep of generated building sizes and light counts and prints
+// the combined results. Each size is a separate run of the scene executable:
+//
+//   <scene> --stress N N K --benchmark 300 --benchmark-csv <csv>
+//
+// which renders 300 frames after a warm-up, appends one line to the CSV and exits.
+//
+//   stress_benchmark path/to/scene.exe [results.csv]
+//
+// Build: g++ -std=c++14 -O2 stress_benchmark.cpp -o stress_benchmark
+// (or add it as a console project next to the scene in Visual Studio)
+
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <string>
+
+int main(int argc, char** argv)
+{
+    if (argc < 2)
+    {
+        std::cout << "usage: stress_benchmark path/to/scene [results.csv]" << std::endl;
+        return 1;
+    }
+    const std::string scene = argv[1];
+    const std::string csv = argc > 2 ? argv[2] : "stress_benchmark.csv";
+    std::remove(csv.c_str());
+
+    // desks per side (3 to a room side) and extra lights
+    const unsigned int deskSides[] = { 3, 6, 12, 24 };
+    const unsigned int lightCounts[] = { 0, 8, 16, 28 };
+    for (unsigned int desks : deskSides)
+    {
+        for (unsigned int lights : lightCounts)
+        {
+            std::string command = "\"" + scene + "\" --stress " + std::to_string(desks) + " " + std::to_string(desks) + " " +
+                                  std::to_string(lights) + " --benchmark 300 --benchmark-csv \"" + csv + "\"";
+#ifdef _WIN32
+            command = "\"" + command + "\"";  // cmd.exe strips the outer pair of quotes
+#endif
+            std::cout << command << std::endl;
+            if (std::system(command.c_str()) != 0)
+                std::cout << "run failed: " << desks << "x" << desks << " desks, " << lights << " lights" << std::endl;
+        }
+    }
+
+    std::ifstream results(csv.c_str());
+    std::cout << std::endl << results.rdbuf();
+    return 0;
+}
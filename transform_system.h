@@ -0,0 +1,222 @@
+#ifndef TRANSFORM_SYSTEM_H
+#define TRANSFORM_SYSTEM_H
+
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+#include <glm/gtc/type_ptr.hpp>
+
+#include <vector>
+#include <cstdint>
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#include <xmmintrin.h>
+#define TRANSFORM_SYSTEM_SSE 1
+#endif
+
+// Stores local transforms (translation, rotation, scale) for every scene object in a
+// structure-of-arrays layout and keeps a world matrix per object. Only objects that
+// were changed since the last update are recomputed, four at a time when SSE is
+// available, so static objects cost nothing per frame after their first update.
+class TransformSystem
+{
+public:
+    typedef unsigned int Handle;
+    static const int NO_PARENT = -1;
+
+    // adds an object with local matrix T * R * S, optionally relative to a parent added earlier
+    Handle Add(glm::vec3 translation, glm::quat rotation, glm::vec3 scale, int parent = NO_PARENT)
+    {
+        Handle id = static_cast<Handle>(parents.size());
+        tx.push_back(translation.x); ty.push_back(translation.y); tz.push_back(translation.z);
+        qx.push_back(rotation.x); qy.push_back(rotation.y); qz.push_back(rotation.z); qw.push_back(rotation.w);
+        sx.push_back(scale.x); sy.push_back(scale.y); sz.push_back(scale.z);
+        parents.push_back(parent);
+        dirty.push_back(1);
+        local.push_back(glm::mat4(1.0f));
+        world.push_back(glm::mat4(1.0f));
+        anyDirty = true;
+        return id;
+    }
+
+    void SetTranslation(Handle id, glm::vec3 t)
+    {
+        tx[id] = t.x; ty[id] = t.y; tz[id] = t.z;
+        MarkDirty(id);
+    }
+
+    void SetRotation(Handle id, glm::quat q)
+    {
+        qx[id] = q.x; qy[id] = q.y; qz[id] = q.z; qw[id] = q.w;
+        MarkDirty(id);
+    }
+
+    void SetScale(Handle id, glm::vec3 s)
+    {
+        sx[id] = s.x; sy[id] = s.y; sz[id] = s.z;
+        MarkDirty(id);
+    }
+
+    const glm::mat4& World(Handle id) const
+    {
+        return world[id];
+    }
+
+    glm::vec3 Translation(Handle id) const
+    {
+        return glm::vec3(tx[id], ty[id], tz[id]);
+    }
+
+    glm::quat Rotation(Handle id) const
+    {
+        return glm::quat(qw[id], qx[id], qy[id], qz[id]);
+    }
+
+    glm::vec3 Scale(Handle id) const
+    {
+        return glm::vec3(sx[id], sy[id], sz[id]);
+    }
+
+    int Parent(Handle id) const
+    {
+        return parents[id];
+    }
+
+    unsigned int Count() const
+    {
+        return static_cast<unsigned int>(parents.size());
+    }
+
+    // recomputes the world matrix of every dirty object (and of its children); returns how many were rebuilt
+    unsigned int UpdateWorld()
+    {
+        if (!anyDirty)
+            return 0;
+
+        const unsigned int count = Count();
+        unsigned int rebuilt = 0;
+
+        // local matrices, in blocks of four so a block is skipped when none of its objects moved
+        for (unsigned int first = 0; first < count; first += 4)
+        {
+            unsigned int n = count - first < 4 ? count - first : 4;
+            bool blockDirty = false;
+            for (unsigned int i = 0; i < n; i++)
+                blockDirty = blockDirty || dirty[first + i];
+            if (!blockDirty)
+                continue;
+#ifdef TRANSFORM_SYSTEM_SSE
+            if (n == 4)
+            {
+                ComposeBlockSSE(first);
+                continue;
+            }
+#endif
+            for (unsigned int i = 0; i < n; i++)
+                ComposeScalar(first + i);
+        }
+
+        // parents always precede their children, so a single forward pass resolves the hierarchy
+        for (unsigned int i = 0; i < count; i++)
+        {
+            int parent = parents[i];
+            if (parent != NO_PARENT && dirty[parent])
+                dirty[i] = 1;
+            if (!dirty[i])
+                continue;
+            world[i] = parent == NO_PARENT ? local[i] : world[parent] * local[i];
+            rebuilt++;
+        }
+        for (unsigned int i = 0; i < count; i++)
+            dirty[i] = 0;
+
+        anyDirty = false;
+        return rebuilt;
+    }
+
+private:
+    // local transform, one array per component
+    std::vector<float> tx, ty, tz;
+    std::vector<float> qx, qy, qz, qw;
+    std::vector<float> sx, sy, sz;
+    std::vector<int> parents;
+    std::vector<std::uint8_t> dirty;
+    std::vector<glm::mat4> local;
+    std::vector<glm::mat4> world;
+    bool anyDirty = false;
+
+    void MarkDirty(Handle id)
+    {
+        dirty[id] = 1;
+        anyDirty = true;
+    }
+
+    void ComposeScalar(unsigned int i)
+    {
+        float x = qx[i], y = qy[i], z = qz[i], w = qw[i];
+        glm::mat4& m = local[i];
+        m[0] = glm::vec4((1.0f - 2.0f * (y * y + z * z)) * sx[i], 2.0f * (x * y + w * z) * sx[i], 2.0f * (x * z - w * y) * sx[i], 0.0f);
+        m[1] = glm::vec4(2.0f * (x * y - w * z) * sy[i], (1.0f - 2.0f * (x * x + z * z)) * sy[i], 2.0f * (y * z + w * x) * sy[i], 0.0f);
+        m[2] = glm::vec4(2.0f * (x * z + w * y) * sz[i], 2.0f * (y * z - w * x) * sz[i], (1.0f - 2.0f * (x * x + y * y)) * sz[i], 0.0f);
+        m[3] = glm::vec4(tx[i], ty[i], tz[i], 1.0f);
+    }
+
+#ifdef TRANSFORM_SYSTEM_SSE
+    // builds the local matrices of objects first..first+3 with one object per SIMD lane
+    void ComposeBlockSSE(unsigned int first)
+    {
+        const __m128 one = _mm_set1_ps(1.0f);
+        const __m128 two = _mm_set1_ps(2.0f);
+        __m128 x = _mm_loadu_ps(&qx[first]);
+        __m128 y = _mm_loadu_ps(&qy[first]);
+        __m128 z = _mm_loadu_ps(&qz[first]);
+        __m128 w = _mm_loadu_ps(&qw[first]);
+        __m128 scaleX = _mm_loadu_ps(&sx[first]);
+        __m128 scaleY = _mm_loadu_ps(&sy[first]);
+        __m128 scaleZ = _mm_loadu_ps(&sz[first]);
+
+        __m128 xx = _mm_mul_ps(x, x), yy = _mm_mul_ps(y, y), zz = _mm_mul_ps(z, z);
+        __m128 xy = _mm_mul_ps(x, y), xz = _mm_mul_ps(x, z), yz = _mm_mul_ps(y, z);
+        __m128 wx = _mm_mul_ps(w, x), wy = _mm_mul_ps(w, y), wz = _mm_mul_ps(w, z);
+
+        // column 0
+        __m128 c0x = _mm_mul_ps(_mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(yy, zz))), scaleX);
+        __m128 c0y = _mm_mul_ps(_mm_mul_ps(two, _mm_add_ps(xy, wz)), scaleX);
+        __m128 c0z = _mm_mul_ps(_mm_mul_ps(two, _mm_sub_ps(xz, wy)), scaleX);
+        // column 1
+        __m128 c1x = _mm_mul_ps(_mm_mul_ps(two, _mm_sub_ps(xy, wz)), scaleY);
+        __m128 c1y = _mm_mul_ps(_mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(xx, zz))), scaleY);
+        __m128 c1z = _mm_mul_ps(_mm_mul_ps(two, _mm_add_ps(yz, wx)), scaleY);
+        // column 2
+        __m128 c2x = _mm_mul_ps(_mm_mul_ps(two, _mm_add_ps(xz, wy)), scaleZ);
+        __m128 c2y = _mm_mul_ps(_mm_mul_ps(two, _mm_sub_ps(yz, wx)), scaleZ);
+        __m128 c2z = _mm_mul_ps(_mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(xx, yy))), scaleZ);
+        // column 3
+        __m128 c3x = _mm_loadu_ps(&tx[first]);
+        __m128 c3y = _mm_loadu_ps(&ty[first]);
+        __m128 c3z = _mm_loadu_ps(&tz[first]);
+
+        __m128 zero = _mm_setzero_ps();
+        __m128 c3w = one;
+        // lanes hold one component for four objects; transpose to get each object's column
+        _MM_TRANSPOSE4_PS(c0x, c0y, c0z, zero);
+        StoreColumns(first, 0, c0x, c0y, c0z, zero);
+        zero = _mm_setzero_ps();
+        _MM_TRANSPOSE4_PS(c1x, c1y, c1z, zero);
+        StoreColumns(first, 1, c1x, c1y, c1z, zero);
+        zero = _mm_setzero_ps();
+        _MM_TRANSPOSE4_PS(c2x, c2y, c2z, zero);
+        StoreColumns(first, 2, c2x, c2y, c2z, zero);
+        _MM_TRANSPOSE4_PS(c3x, c3y, c3z, c3w);
+        StoreColumns(first, 3, c3x, c3y, c3z, c3w);
+    }
+
+    void StoreColumns(unsigned int first, int column, __m128 a, __m128 b, __m128 c, __m128 d)
+    {
+        _mm_storeu_ps(glm::value_ptr(local[first + 0][column]), a);
+        _mm_storeu_ps(glm::value_ptr(local[first + 1][column]), b);
+        _mm_storeu_ps(glm::value_ptr(local[first + 2][column]), c);
+        _mm_storeu_ps(glm::value_ptr(local[first + 3][column]), d);
+    }
+#endif
+};
+#endif
@@ -0,0 +1,172 @@
+#ifndef UNIFORM_RING_H
+#define UNIFORM_RING_H
+
+#include <glad/glad.h>
+#include "gl_counters.h"
+#include "gpu_memory.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <iostream>
+
+// Uniform block bindings shared by every shader that reads from the ring.
+const unsigned int MATRICES_BINDING = 0;   // per-frame projection and view
+const unsigned int OBJECT_BINDING = 1;     // per-draw model matrix
+
+// A triple-buffered uniform buffer for data that is rewritten every frame. With
+// GL_ARB_buffer_storage the buffer is mapped once, persistently, and each frame writes
+// into the section the GPU finished with two frames ago (guarded by a fence). On plain
+// GL 3.3 the buffer is orphaned and mapped again every frame instead, which lets the
+// driver hand out fresh storage rather than stalling on the previous frame's draws.
+//
+// Push() is thread-safe, so worker threads can fill the mapped memory directly;
+// BeginFrame(), Flush() and EndFrame() must be called on the GL thread.
+class UniformRing
+{
+public:
+    static const unsigned int FRAMES = 3;
+    static const GLintptr NO_SPACE = -1;   // what Push() returns once the frame's section is full
+
+    // room for blocksPerFrame pushes of up to blockSize bytes each frame
+    UniformRing(unsigned int blocksPerFrame, GLsizeiptr blockSize)
+    {
+        GLint alignment = 256;
+        glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+        align = alignment > 0 ? alignment : 256;
+        frameSize = blocksPerFrame * RoundUp(blockSize);
+
+        glGenBuffers(1, &buffer);
+        glBindBuffer(GL_UNIFORM_BUFFER, buffer);
+#if defined(GL_ARB_buffer_storage) && defined(GL_MAP_PERSISTENT_BIT)
+        if (GLAD_GL_ARB_buffer_storage)
+        {
+            const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+            glBufferStorage(GL_UNIFORM_BUFFER, frameSize * FRAMES, NULL, flags);
+            persistent = static_cast<char*>(glMapBufferRange(GL_UNIFORM_BUFFER, 0, frameSize * FRAMES, flags));
+        }
+#endif
+        if (!persistent)
+            glBufferData(GL_UNIFORM_BUFFER, frameSize, NULL, GL_STREAM_DRAW);
+        glBindBuffer(GL_UNIFORM_BUFFER, 0);
+        // orphaning hands out fresh storage each frame, but only one frame's worth is live
+        GpuMemory().Allocate(GpuResource::Buffer, buffer, persistent ? frameSize * FRAMES : frameSize,
+                             persistent ? "GL_UNIFORM_BUFFER persistent, 3 frames" : "GL_UNIFORM_BUFFER orphaned", "uniform ring");
+    }
+
+    ~UniformRing()
+    {
+        for (unsigned int i = 0; i < FRAMES; i++)
+        {
+            if (fences[i])
+                glDeleteSync(fences[i]);
+        }
+        glBindBuffer(GL_UNIFORM_BUFFER, buffer);
+        if (persistent || mapped)
+            glUnmapBuffer(GL_UNIFORM_BUFFER);
+        glBindBuffer(GL_UNIFORM_BUFFER, 0);
+        DeleteBuffer(buffer);
+    }
+
+    UniformRing(const UniformRing&) = delete;
+    UniformRing& operator=(const UniformRing&) = delete;
+
+    unsigned int Buffer() const
+    {
+        return buffer;
+    }
+
+    bool Persistent() const
+    {
+        return persistent != NULL;
+    }
+
+    // makes this frame's section writable
+    void BeginFrame()
+    {
+        used = 0;
+        dropped = 0;
+        if (persistent)
+        {
+            // the section was last used FRAMES frames ago, so this fence has normally long signaled
+            if (fences[section])
+            {
+                GLenum status = glClientWaitSync(fences[section], GL_SYNC_FLUSH_COMMANDS_BIT, 1000000);
+                while (status == GL_TIMEOUT_EXPIRED)
+                    status = glClientWaitSync(fences[section], 0, 1000000);
+                if (status == GL_WAIT_FAILED)
+                {
+                    // the fence is no use; wait for the whole pipeline instead of writing under the GPU
+                    std::cout << "ERROR::UNIFORM_RING::WAIT_FAILED: fence for section " << section << std::endl;
+                    glFinish();
+                }
+                glDeleteSync(fences[section]);
+                fences[section] = 0;
+            }
+            mapped = persistent + section * frameSize;
+            base = section * frameSize;
+            return;
+        }
+        glBindBuffer(GL_UNIFORM_BUFFER, buffer);
+        glBufferData(GL_UNIFORM_BUFFER, frameSize, NULL, GL_STREAM_DRAW);
+        mapped = static_cast<char*>(glMapBufferRange(GL_UNIFORM_BUFFER, 0, frameSize, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT));
+        glBindBuffer(GL_UNIFORM_BUFFER, 0);
+        base = 0;
+    }
+
+    // copies size bytes into this frame's section and returns the buffer offset to bind, or
+    // NO_SPACE when the section is full; the caller must then drop whatever needed the data
+    GLintptr Push(const void* data, GLsizeiptr size)
+    {
+        GLsizeiptr offset = used.fetch_add(RoundUp(size));
+        if (offset + size > frameSize)
+        {
+            dropped++;
+            return NO_SPACE;
+        }
+        std::memcpy(mapped + offset, data, size);
+        return base + offset;
+    }
+
+    // makes everything written so far visible to the GPU; call before drawing
+    void Flush()
+    {
+        if (persistent || !mapped)
+            return;
+        glBindBuffer(GL_UNIFORM_BUFFER, buffer);
+        glUnmapBuffer(GL_UNIFORM_BUFFER);
+        glBindBuffer(GL_UNIFORM_BUFFER, 0);
+        mapped = NULL;
+    }
+
+    // call after the frame's last draw that reads from the ring
+    void EndFrame()
+    {
+        if (dropped > 0)
+            std::cout << "ERROR::UNIFORM_RING::OUT_OF_SPACE " << dropped << " pushes dropped, " << frameSize << " bytes per frame" << std::endl;
+        GL_COUNT_MAPPED_BYTES(std::min(used.load(), frameSize));
+        if (persistent)
+        {
+            fences[section] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+            section = (section + 1) % FRAMES;
+        }
+    }
+
+private:
+    unsigned int buffer = 0;
+    GLsizeiptr align = 256;
+    GLsizeiptr frameSize = 0;
+    char* persistent = NULL;
+    char* mapped = NULL;
+    GLintptr base = 0;
+    std::atomic<GLsizeiptr> used{ 0 };
+    std::atomic<unsigned int> dropped{ 0 };
+    unsigned int section = 0;
+    GLsync fences[FRAMES] = {};
+
+    GLsizeiptr RoundUp(GLsizeiptr size) const
+    {
+        return (size + align - 1) / align * align;
+    }
+};
+#endif